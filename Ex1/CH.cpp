@@ -2,7 +2,9 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
-#include <sstream>
+#include "../common/SimdKernels.hpp"
+#include "../common/HullFilter.hpp"
+#include "../common/PointParser.hpp"
 
 using namespace std;
 
@@ -45,46 +47,40 @@ vector<Point> convexHull(vector<Point> &points) {
 
 // Calculate polygon area
 float polygonArea(const vector<Point> &poly) {
-    float area = 0;
-    int n = poly.size();
-    for (int i = 0; i < n; ++i) {
-        area += poly[i].x * poly[(i+1)%n].y - poly[i].y * poly[(i+1)%n].x;
-    }
-    return abs(area) / 2.0;
+    PointBuffer soa;
+    soa.assign(poly);
+    return polygonAreaSoA(soa);
 }
 
-int main() {
-    int numPoints;
-    if (!(cin >> numPoints) || numPoints <= 0) {
+int main(int argc, char* argv[]) {
+    // "CH file" maps the file and parses it on every core; otherwise stdin
+    vector<Point> points;
+    PointLoad load = argc > 1 ? mapPointFile(argv[1], points) : readPointStream(0, points);
+    switch (load.status) {
+    case PointParser::OPEN:
+        cerr << "Error: Cannot read " << argv[1] << "." << endl;
+        return 1;
+    case PointParser::COUNT:
         cerr << "Error: Invalid number of points." << endl;
         return 1;
+    case PointParser::END:
+        cerr << "Error: Not enough input lines." << endl;
+        return 1;
+    case PointParser::INVALID:
+        cerr << "Error: Invalid point format at line " << load.line << "." << endl;
+        return 1;
+    case PointParser::EXTRA:
+        cerr << "Error: Extra data in line " << load.line << "." << endl;
+        return 1;
+    case PointParser::OK:
+        break;
     }
-    cin.ignore(); 
-
-    vector<Point> points;
-    for (int i = 0; i < numPoints; ++i) {
-        string line;
-        if (!getline(cin, line)) {
-            cerr << "Error: Not enough input lines." << endl;
-            return 1;
-        }
-
-        replace(line.begin(), line.end(), ',', ' ');
-
-        stringstream ss(line);
-        Point p;
-        if (!(ss >> p.x >> p.y)) {
-            cerr << "Error: Invalid point format at line " << i + 1 << "." << endl;
-            return 1;
-        }
-
-        string extra;
-        if (ss >> extra) {
-            cerr << "Error: Extra data in line " << i + 1 << "." << endl;
-            return 1;
-        }
+    int numPoints = points.size();
 
-        points.push_back(p);
+    // Drop points that cannot be on the hull before sorting
+    size_t discarded = aklToussaintFilter(points);
+    if (discarded > 0) {
+        cerr << "Akl-Toussaint: discarded " << discarded << " of " << numPoints << " points." << endl;
     }
 
     vector<Point> hull = convexHull(points);
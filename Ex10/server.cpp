@@ -1,7 +1,6 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <sstream>
 #include <algorithm>
 #include <cmath>
 #include <sys/socket.h>
@@ -9,10 +8,19 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
+#include <cerrno>
 #include <map>
 #include <set>
 #include <pthread.h>
 #include "../Ex8/Reactor.hpp"
+#include "../common/IncrementalHull.hpp"
+#include "../common/PointStore.hpp"
+#include "../common/EpochPtr.hpp"
+#include "../common/BinaryGraph.hpp"
+#include "../common/ReplyBuffer.hpp"
+#include "../common/LineBuffer.hpp"
+#include "../common/GraphRegistry.hpp"
+#include "../common/AreaMonitor.hpp"
 
 
 // Point structure 
@@ -29,230 +37,436 @@ struct Point {
 };
 
 // Global variables 
-std::vector<Point> graph;
-pthread_mutex_t graph_mutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_cond_t ch_area_cond = PTHREAD_COND_INITIALIZER;
-bool area_above_100 = false;
-
-// Helper functions for convex hull calculation
-double cross(const Point& O, const Point& A, const Point& B) {
-    return (A.x - O.x) * (B.y - O.y) - (A.y - O.y) * (B.x - O.x);
+// Immutable view of a graph, published by the first CH after a change
+// (see NamedGraph::current); CH reads it without taking the graph's mutex
+struct GraphSnapshot {
+    std::vector<Point> hull;
+    double area;
+    unsigned long version; // The graph's version it was made from
+    GraphSnapshot() : area(0.0), version(0) {}
+};
+
+// Named graphs, each with its own mutex (see GraphRegistry.hpp); points
+// match within 1e-9, the same tolerance as Point::operator==
+typedef NamedGraph<Point, GraphSnapshot> Graph;
+GraphRegistry<Graph> graphs(1e-9);
+Graph* default_graph = graphs.get(GRAPH_DEFAULT_NAME); // Watched by the area monitor
+AreaMonitor area_monitor; // Fed default_graph's area by commitGraph and publishGraph
+
+// Subscribe (to the area of default_graph): threshold -> subscribed fd, ordered so a change of area visits
+// only the thresholds it crossed. Notifications are queued on notify_reactor,
+// which from then on also carries the connection's replies, so the two never
+// interleave and a slow subscriber never blocks the monitor or a handler
+std::multimap<double, int> subscriptions;
+double notified_area = 0.0; // The area of the last notification
+pthread_mutex_t subscriptions_mutex = PTHREAD_MUTEX_INITIALIZER; // Protects both
+void* notify_reactor = nullptr;
+
+// Publishes g's hull as a new snapshot; call with g->mutex held
+void publishGraph(Graph* g) {
+    GraphSnapshot* snap = new GraphSnapshot();
+    snap->hull = g->hull.hull(g->points);
+    snap->area = g->hull.area(g->points);
+    snap->version = g->version.load();
+    g->snapshot.publish(snap);
+    if (g == default_graph) area_monitor.publish(snap->area);
 }
 
-std::vector<Point> convexHull(std::vector<Point> points) {
-    if (points.size() <= 1) return points;
-    int min_idx = 0;
-    for (int i = 1; i < (int)points.size(); i++) {
-        if (points[i].y < points[min_idx].y || 
-            (points[i].y == points[min_idx].y && points[i].x < points[min_idx].x)) {
-            min_idx = i;
-        }
+// A change to g is complete; call with g->mutex held. The monitor gets the
+// default graph's area when the incremental hull still has it; a change that
+// dirtied the hull reaches it with the next CH, which rebuilds anyway
+void commitGraph(Graph* g) {
+    g->changed();
+    double area;
+    if (g == default_graph && g->hull.cachedArea(area)) area_monitor.publish(area);
+}
+
+// Sends a batch of replies; once a connection subscribed they are queued
+// behind its notifications. On failure the connection is shut down, so its
+// handler sees the close
+void sendReplies(int fd, std::string& reply, bool on_reactor) {
+    bool ok;
+    if (on_reactor) {
+        ok = reply.empty() || sendToReactor(notify_reactor, fd, reply.data(), reply.size()) == 0;
+        reply.clear();
+    } else {
+        ok = flushReplies(fd, reply);
     }
-    std::swap(points[0], points[min_idx]);
-    Point pivot = points[0];
-    std::sort(points.begin() + 1, points.end(), [&](const Point& a, const Point& b) {
-        double cross_prod = cross(pivot, a, b);
-        if (cross_prod == 0) {
-            double dist_a = (a.x - pivot.x) * (a.x - pivot.x) + (a.y - pivot.y) * (a.y - pivot.y);
-            double dist_b = (b.x - pivot.x) * (b.x - pivot.x) + (b.y - pivot.y) * (b.y - pivot.y);
-            return dist_a < dist_b;
-        }
-        return cross_prod > 0;
-    });
-    std::vector<Point> hull;
-    for (const Point& p : points) {
-        while (hull.size() >= 2 && cross(hull[hull.size()-2], hull[hull.size()-1], p) < 0) {
-            hull.pop_back();
+    if (!ok) shutdown(fd, SHUT_RDWR);
+}
+
+// Drops the subscriptions of fd; with leaving, its queued output too
+void unsubscribe(int fd, std::vector<double>& thresholds, bool leaving) {
+    pthread_mutex_lock(&subscriptions_mutex);
+    for (double t : thresholds) {
+        auto range = subscriptions.equal_range(t);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == fd) {
+                subscriptions.erase(it);
+                break;
+            }
         }
-        hull.push_back(p);
     }
-    return hull;
+    pthread_mutex_unlock(&subscriptions_mutex);
+    thresholds.clear();
+    if (leaving) removeFdFromReactor(notify_reactor, fd);
 }
 
-double calculateArea(const std::vector<Point>& hull) {
-    if (hull.size() < 3) return 0.0;
-    double area = 0.0;
-    int n = hull.size();
-    for (int i = 0; i < n; i++) {
-        int j = (i + 1) % n;
-        area += hull[i].x * hull[j].y;
-        area -= hull[j].x * hull[i].y;
+// Pushes a notification to every subscriber whose threshold the area crossed
+// going from `from` to `to`; runs on the monitor thread
+void notifySubscribers(double from, double to) {
+    const char* change = to > from ? "belongs" : "no longer belongs";
+    char line[128];
+    int len = 0;
+    double formatted = 0.0;
+    pthread_mutex_lock(&subscriptions_mutex);
+    // Crossed thresholds t satisfy min < t <= max
+    auto end = subscriptions.upper_bound(std::max(from, to));
+    for (auto it = subscriptions.upper_bound(std::min(from, to)); it != end; ++it) {
+        if (len == 0 || it->first != formatted) {
+            formatted = it->first;
+            len = snprintf(line, sizeof(line), "Notify: At Least %g units %s to CH\n", formatted, change);
+        }
+        if (sendToReactor(notify_reactor, it->second, line, len) != 0) shutdown(it->second, SHUT_RDWR);
     }
-    return std::abs(area) / 2.0;
+    notified_area = to;
+    pthread_mutex_unlock(&subscriptions_mutex);
 }
 
-// Handler for client connections
-void* client_handler(int client_fd) {
-    char buffer[1024];
-    std::string client_buffer;
-    bool waiting_for_points = false;
-    int points_remaining = 0;
+// A client connection. A worker serves it until it subscribes; from the end
+// of that batch on notify_reactor serves its reads too (see subscriberInput),
+// so a subscriber waiting for notifications holds no worker
+struct Connection {
+    int fd;
+    LineBuffer input; // Commands are framed in place, without copies
+    std::string reply; // Replies to the commands of one received batch
+    Graph* g; // Graph this connection works on
+    bool on_reactor; // Replies go through notify_reactor
+    std::vector<double> subscribed; // This connection's thresholds
+    // A Newgraph upload in progress: its points are collected here, without
+    // g->mutex, and swapped into g once the last one arrived
+    PointStore<Point> loaded;
+    long points_remaining; // Text points still expected
+    long binary_remaining; // Packed points still expected
+
+    explicit Connection(int fd)
+        : fd(fd), g(default_graph), on_reactor(false), loaded(graphs.eps()), points_remaining(0),
+          binary_remaining(0) {}
+};
 
+// Subscribed connections whose reads notify_reactor serves, by fd
+std::map<int, Connection*> reactor_connections;
+pthread_mutex_t reactor_connections_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Starts collecting a new graph for c->g
+void beginUpload(Connection* c) {
+    PointStore<Point> fresh(graphs.eps());
+    c->loaded.swap(fresh);
+}
+
+// Replaces c->g's points with the ones collected and rebuilds once; the old
+// points are freed after g->mutex is released. Returns the new size
+size_t commitUpload(Connection* c) {
+    Graph* g = c->g;
+    pthread_mutex_lock(&g->mutex);
+    if (g == default_graph) area_monitor.reset(); // Reported thresholds start afresh, subscribers do not
+    g->points.swap(c->loaded);
+    g->hull.reset();
+    g->hull.invalidate();
+    commitGraph(g);
+    // The uploader builds the default graph's snapshot, so the monitor and
+    // new subscribers see the new area without waiting for a CH
+    if (g == default_graph) publishGraph(g);
+    size_t count = g->points.size();
+    pthread_mutex_unlock(&g->mutex);
+    beginUpload(c);
+    return count;
+}
+
+void finishUpload(Connection* c) {
+    size_t count = commitUpload(c);
+    c->reply += "Graph created with ";
+    c->reply += std::to_string(count);
+    c->reply += " points\n";
+}
+
+// Runs the commands buffered in c->input and feeds an upload in progress,
+// collecting the replies in c->reply. Never blocks on the socket, and holds
+// a graph's mutex only for one command, so it also runs on notify_reactor
+void serveInput(Connection* c) {
+    std::string_view command;
     while (true) {
-        ssize_t bytes = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-        if (bytes <= 0) {
-            if (bytes == 0) {
-                std::cout << "Client " << client_fd << " disconnected normally\n";
-            } else {
-                perror("recv");
-            }
-            break;
+        if (c->binary_remaining > 0) {
+            // The packed points follow the command line; take what arrived
+            c->binary_remaining -= takeBinaryPoints(c->input, c->binary_remaining, c->loaded);
+            if (c->binary_remaining > 0) return;
+            finishUpload(c);
+            continue;
         }
-        buffer[bytes] = '\0';
-        client_buffer += buffer;
-        
-        size_t pos;
-        while ((pos = client_buffer.find('\n')) != std::string::npos) {
-            std::string command = client_buffer.substr(0, pos);
-            client_buffer.erase(0, pos + 1);
-            if (!command.empty() && command.back() == '\r') command.pop_back();
-            
-            std::istringstream iss(command);
-            std::string cmd;
-            iss >> cmd;
-            
-            if (waiting_for_points) {
-                size_t comma_pos = command.find(',');
-                if (comma_pos != std::string::npos) {
-                    try {
-                        double x = std::stod(command.substr(0, comma_pos));
-                        double y = std::stod(command.substr(comma_pos + 1));
-                        
-                        graph.push_back(Point(x, y));
-                        points_remaining--;
-                        
-                        if (points_remaining == 0) {
-                            waiting_for_points = false;
-                            std::string response = "Graph created with " + std::to_string(graph.size()) + " points\n";
-                            send(client_fd, response.c_str(), response.length(), 0);
-                            pthread_mutex_unlock(&graph_mutex);
-                        }
-                    } catch (...) {
-                        std::string error = "Invalid point format\n";
-                        send(client_fd, error.c_str(), error.length(), 0);
-                        waiting_for_points = false;
-                        pthread_mutex_unlock(&graph_mutex);
-                    }
+        if (!c->input.nextLine(command)) return;
+
+        std::string_view args = command;
+        std::string_view cmd = nextToken(args);
+        std::string& reply = c->reply;
+        Graph*& g = c->g;
+        double x, y;
+
+        if (c->points_remaining > 0) {
+            if (command.find(',') != std::string_view::npos) {
+                if (parseCoords(command, x, y)) {
+                    c->loaded.push_back(Point(x, y));
+                    if (--c->points_remaining == 0) finishUpload(c);
+                } else {
+                    reply += "Invalid point format\n";
+                    c->points_remaining = 0;
+                    commitUpload(c);
                 }
             }
+        }
 
-            else if (cmd == "Newgraph") {
-                pthread_mutex_lock(&graph_mutex);
-                area_above_100 = false; // Reset area flag
-                int n;
-                if (iss >> n) {
-                    graph.clear();
-                    if (n > 0) {
-                        waiting_for_points = true;
-                        points_remaining = n;
-                        std::string response = "Ready to receive " + std::to_string(n) + " points. Send them as x,y format:\n";
-                        send(client_fd, response.c_str(), response.length(), 0);
-                    } else {
-                        std::string response = "Empty graph created\n";
-                        send(client_fd, response.c_str(), response.length(), 0);
-                        pthread_mutex_unlock(&graph_mutex);
-                    }
+        else if (cmd == BINARY_GRAPH_COMMAND) {
+            long n;
+            if (!parseNewgraphArgs(graphs, args, g, n) || n < 0 || n > BINARY_GRAPH_MAX_POINTS) {
+                reply += "Invalid Newgraph-binary command format\n";
+                continue;
+            }
+            if (!graphs.admit(g, n)) {
+                reply += "Graph memory limit reached\n";
+                continue;
+            }
+            // Storage grows with the points that arrive, not with n
+            beginUpload(c);
+            if (n == 0) finishUpload(c);
+            c->binary_remaining = n;
+        }
+        else if (cmd == "Newgraph") {
+            int n;
+            if (parseNewgraphArgs(graphs, args, g, n)) {
+                if (!graphs.admit(g, std::max(n, 0))) {
+                    reply += "Graph memory limit reached\n";
+                    continue;
+                }
+                beginUpload(c);
+                if (n > 0) {
+                    c->points_remaining = n;
+                    reply += "Ready to receive ";
+                    reply += std::to_string(n);
+                    reply += " points. Send them as x,y format:\n";
                 } else {
-                    std::string error = "Invalid Newgraph command format\n";
-                    send(client_fd, error.c_str(), error.length(), 0);
-                    pthread_mutex_unlock(&graph_mutex);
+                    commitUpload(c);
+                    reply += "Empty graph created\n";
                 }
+            } else {
+                reply += "Invalid Newgraph command format\n";
             }
-            else if (cmd == "CH") {
-                pthread_mutex_lock(&graph_mutex);
-                std::vector<Point> hull = convexHull(graph);
-                double area = calculateArea(hull);
-                std::string response = std::to_string(area) + "\n";
-                send(client_fd, response.c_str(), response.length(), 0);
-                pthread_cond_signal(&ch_area_cond);
-                pthread_mutex_unlock(&graph_mutex);
+        }
+        else if (cmd == "Use") {
+            Graph* next = graphs.get(nextToken(args));
+            if (next) {
+                g = next;
+                reply += "Using graph ";
+                reply += g->name;
+                reply += '\n';
+            } else {
+                reply += "Invalid graph name\n";
             }
-            else if (cmd == "Newpoint") {
-                pthread_mutex_lock(&graph_mutex);
-                std::string coords;
-                iss >> coords;
-                size_t comma_pos = coords.find(',');
-                if (comma_pos != std::string::npos) {
-                    try {
-                        double x = std::stod(coords.substr(0, comma_pos));
-                        double y = std::stod(coords.substr(comma_pos + 1));
-                        graph.push_back(Point(x, y));
-                        std::string response = "Point added\n";
-                        send(client_fd, response.c_str(), response.length(), 0);
-                    } catch (...) {
-                        std::string error = "Invalid point format\n";
-                        send(client_fd, error.c_str(), error.length(), 0);
-                    }
-                } else {
-                    std::string error = "Invalid point format\n";
-                    send(client_fd, error.c_str(), error.length(), 0);
+        }
+        else if (cmd == "Stats") {
+            size_t count, total;
+            graphs.totals(count, total);
+            char line[320];
+            snprintf(line, sizeof(line), "Graph %s: %zu points, %zu bytes, version %lu, CH cache %lu hits, "
+                     "%lu misses, %lu shared (%zu graphs, %zu bytes in all)\n", g->name.c_str(),
+                     g->size.load(), g->bytes.load(), g->version.load(), g->hits.load(), g->misses.load(),
+                     g->shared.load(), count, total);
+            reply += line;
+        }
+        else if (cmd == "CH") {
+            // Lock-free unless the graph changed since the last CH; then
+            // one CH publishes and the ones arriving meanwhile share it
+            double area = g->current(publishGraph, [](const GraphSnapshot& s) { return s.area; });
+            reply += std::to_string(area);
+            reply += '\n';
+        }
+        else if (cmd == "Newpoint") {
+            if (parseCoords(nextToken(args), x, y)) {
+                if (!graphs.fits(1)) {
+                    reply += "Graph memory limit reached\n";
+                    continue;
                 }
-                pthread_mutex_unlock(&graph_mutex);
+                pthread_mutex_lock(&g->mutex);
+                g->points.push_back(Point(x, y));
+                g->hull.insert(g->points.back());
+                commitGraph(g);
+                pthread_mutex_unlock(&g->mutex);
+                reply += "Point added\n";
+            } else {
+                reply += "Invalid point format\n";
             }
-            else if (cmd == "Removepoint") {
-                pthread_mutex_lock(&graph_mutex);
-                std::string coords;
-                iss >> coords;
-                size_t comma_pos = coords.find(',');
-                if (comma_pos != std::string::npos) {
-                    try {
-                        double x = std::stod(coords.substr(0, comma_pos));
-                        double y = std::stod(coords.substr(comma_pos + 1));
-                        auto it = std::find(graph.begin(), graph.end(), Point(x, y));
-                        if (it != graph.end()) {
-                            graph.erase(it);
-                            std::string response = "Point removed\n";
-                            send(client_fd, response.c_str(), response.length(), 0);
-                            pthread_cond_signal(&ch_area_cond);
-                        } else {
-                            std::string response = "Point not found\n";
-                            send(client_fd, response.c_str(), response.length(), 0);
-                        }
-                    } catch (...) {
-                        std::string error = "Invalid point format\n";
-                        send(client_fd, error.c_str(), error.length(), 0);
-                    }
+        }
+        else if (cmd == "Removepoint") {
+            if (parseCoords(nextToken(args), x, y)) {
+                pthread_mutex_lock(&g->mutex);
+                long idx = g->points.find(x, y);
+                if (idx >= 0) {
+                    g->hull.remove(g->points[idx]);
+                    g->points.erase(idx);
+                    commitGraph(g);
+                    reply += "Point removed\n";
                 } else {
-                    std::string error = "Invalid point format\n";
-                    send(client_fd, error.c_str(), error.length(), 0);
+                    reply += "Point not found\n";
                 }
-                pthread_mutex_unlock(&graph_mutex);
+                pthread_mutex_unlock(&g->mutex);
+            } else {
+                reply += "Invalid point format\n";
             }
-            else {
-                std::string error = "Unknown command\n";
-                send(client_fd, error.c_str(), error.length(), 0);
+        }
+        else if (cmd == "Subscribe") {
+            double threshold;
+            if (!parseLeading(args, threshold)) {
+                reply += "Invalid Subscribe command format\n";
+                continue;
             }
+            if (!c->on_reactor) {
+                c->on_reactor = addFdToReactor(notify_reactor, c->fd, nullptr) == 0;
+                if (!c->on_reactor) {
+                    reply += "Subscribe failed\n";
+                    continue;
+                }
+            }
+            sendReplies(c->fd, reply, true);
+            // The confirmation says where the area stood at the last
+            // notification and goes out before any later one can
+            char line[160];
+            pthread_mutex_lock(&subscriptions_mutex);
+            const char* state = notified_area >= threshold ? "belongs" : "does not belong";
+            int len = snprintf(line, sizeof(line), "Subscribed to %g units: At Least %g units %s to CH\n",
+                               threshold, threshold, state);
+            bool sent = sendToReactor(notify_reactor, c->fd, line, len) == 0;
+            subscriptions.insert(std::make_pair(threshold, c->fd));
+            pthread_mutex_unlock(&subscriptions_mutex);
+            if (!sent) shutdown(c->fd, SHUT_RDWR);
+            c->subscribed.push_back(threshold);
+        }
+        else if (cmd == "Unsubscribe") {
+            unsubscribe(c->fd, c->subscribed, false);
+            reply += "Unsubscribed\n";
         }
+        else {
+            reply += "Unknown command\n";
+        }
+    }
+}
+
+// One recv for c and the commands it completed; false once c must close
+bool readConnection(Connection* c) {
+    ssize_t bytes = c->input.fill(c->fd);
+    if (bytes <= 0) {
+        if (bytes == 0) {
+            std::cout << "Client " << c->fd << " disconnected normally\n";
+        } else if (errno == EMSGSIZE) {
+            std::cout << "Client " << c->fd << " sent a line over " << LINE_BUFFER_CAPACITY << " bytes\n";
+        } else {
+            perror("recv");
+        }
+        return false;
     }
+    serveInput(c);
+    // One send for everything this batch produced
+    sendReplies(c->fd, c->reply, c->on_reactor);
+    return true;
+}
+
+// Drops what c left behind; an unfinished upload never reaches its graph
+void endConnection(Connection* c) {
+    if (c->on_reactor) unsubscribe(c->fd, c->subscribed, true);
+    delete c;
+}
 
+// Read callback of a subscribed connection, on notify_reactor's thread
+void* subscriberInput(int fd) {
+    pthread_mutex_lock(&reactor_connections_mutex);
+    auto it = reactor_connections.find(fd);
+    Connection* c = it != reactor_connections.end() ? it->second : nullptr;
+    pthread_mutex_unlock(&reactor_connections_mutex);
+    if (c == nullptr || readConnection(c)) return nullptr;
+
+    pthread_mutex_lock(&reactor_connections_mutex);
+    reactor_connections.erase(fd);
+    pthread_mutex_unlock(&reactor_connections_mutex);
+    endConnection(c);
+    close(fd);
     return nullptr;
 }
 
+// Handler for client connections
+void* client_handler(int client_fd) {
+    Connection* c = new Connection(client_fd);
+    while (readConnection(c)) {
+        if (!c->on_reactor) continue;
+        // Subscribed: notify_reactor reads the connection from now on and
+        // the worker goes back to the pool
+        pthread_mutex_lock(&reactor_connections_mutex);
+        reactor_connections[client_fd] = c;
+        pthread_mutex_unlock(&reactor_connections_mutex);
+        if (addFdToReactor(notify_reactor, client_fd, subscriberInput) == 0) return PROACTOR_FD_KEPT;
+        pthread_mutex_lock(&reactor_connections_mutex);
+        reactor_connections.erase(client_fd);
+        pthread_mutex_unlock(&reactor_connections_mutex);
+        break;
+    }
+    endConnection(c);
+    return nullptr;
+}
 
-void* ch_monitor_thread(void*) {
-    std::vector<Point> local_copy;
-    while (true) {
-        pthread_mutex_lock(&graph_mutex);
-        pthread_cond_wait(&ch_area_cond, &graph_mutex); // wait for signal from client handler
-        
-        local_copy = graph;
-        std::vector<Point> hull = convexHull(local_copy);
-        double area = calculateArea(hull);
-        
-        if (area >= 100.0 && !area_above_100) {
-            std::cout << "At Least 100 units belongs to CH\n";
-            area_above_100 = true;
-        } else if (area < 100.0 && area_above_100) {
-            std::cout << "At Least 100 units no longer belongs to CH\n";
-            area_above_100 = false;
-        }
 
-        pthread_mutex_unlock(&graph_mutex);
+void reportArea(double level, bool above, double) {
+    if (above) {
+        std::cout << "At Least " << level << " units belongs to CH\n";
+    } else {
+        std::cout << "At Least " << level << " units no longer belongs to CH\n";
     }
+}
+
+// Reports threshold crossings of the areas commitGraph and publishGraph hand
+// over and notifies subscribers; never touches a graph's mutex
+void* ch_monitor_thread(void*) {
+    area_monitor.run(reportArea, notifySubscribers);
     return nullptr;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Thresholds as --threshold LEVEL[:HYSTERESIS], 100 if none are given.
+    // Every connection holds a worker until it subscribes: --workers N
+    bool thresholds = false;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--threshold" && i + 1 < argc) {
+            std::string_view arg = argv[++i], rest;
+            double level, hysteresis = 0.0;
+            size_t colon = arg.find(':');
+            if (colon != std::string_view::npos) rest = arg.substr(colon + 1);
+            if (!parseLeading(arg.substr(0, colon), level) ||
+                (!rest.empty() && !parseLeading(rest, hysteresis)) || hysteresis < 0) {
+                std::cerr << "Error: Invalid threshold " << arg << "\n";
+                return 1;
+            }
+            area_monitor.addThreshold(level, hysteresis);
+            thresholds = true;
+        } else if (a == "--workers" && i + 1 < argc) {
+            int n;
+            if (!parseLeading(std::string_view(argv[++i]), n) || n < 1) {
+                std::cerr << "Error: Invalid worker count\n";
+                return 1;
+            }
+            setProactorWorkers(n);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--threshold LEVEL[:HYSTERESIS]]... [--workers N]\n";
+            return 1;
+        }
+    }
+    if (!thresholds) area_monitor.addThreshold(100.0, 0.0);
+
     int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (listen_fd < 0) {
         perror("socket");
@@ -282,6 +496,14 @@ int main() {
     
     std::cout << "Server running on port 9034\n";
     
+    // Write path for subscribers
+    notify_reactor = startReactor();
+    if (notify_reactor == nullptr) {
+        std::cerr << "Failed to start reactor\n";
+        close(listen_fd);
+        return 1;
+    }
+
     // starting the Proactor
     pthread_t proactor_tid = startProactor(listen_fd, client_handler);
     if (proactor_tid == 0) {
@@ -303,8 +525,7 @@ int main() {
     
     // cleanup
     stopProactor(proactor_tid);
+    stopReactor(notify_reactor);
     close(listen_fd);
-    pthread_mutex_destroy(&graph_mutex);
-    pthread_cond_destroy(&ch_area_cond);
     return 0;
 }
\ No newline at end of file
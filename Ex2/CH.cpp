@@ -2,9 +2,13 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
-#include <sstream>
-#include <deque>
 #include <chrono>
+#include "../common/SimdKernels.hpp"
+#include "../common/ParallelHull.hpp"
+#include "../common/HullFilter.hpp"
+#include "../common/PointParser.hpp"
+#include "../common/ChanHull.hpp"
+#include "../common/HullEngines.hpp"
 
 using namespace std;
 
@@ -45,74 +49,46 @@ vector<Point> convexHull_vector(vector<Point> &points) {
     return hull;
 }
 
-vector<Point> convexHullDeque(vector<Point> P) {
-    int n = P.size();
-    sort(P.begin(), P.end());
-    deque<Point> hull;
-
-    for (int i = 0; i < n; i++) {
-        while (hull.size() >= 2 && cross(hull[hull.size()-2], hull.back(), P[i]) <= 0)
-            hull.pop_back();
-        hull.push_back(P[i]);
-    }
-
-    long unsigned int t = hull.size() + 1;
-    for (int i = n - 2; i >= 0; i--) {
-        while (hull.size() >= t && cross(hull[hull.size()-2], hull.back(), P[i]) <= 0)
-            hull.pop_back();
-        hull.push_back(P[i]);
-    }
-
-    hull.pop_back(); // remove duplicate
-    return vector<Point>(hull.begin(), hull.end());
-}
-
 // Calculate polygon area
 float polygonArea(const vector<Point> &poly) {
-    float area = 0;
-    int n = poly.size();
-    for (int i = 0; i < n; ++i) {
-        area += poly[i].x * poly[(i+1)%n].y - poly[i].y * poly[(i+1)%n].x;
-    }
-    return abs(area) / 2.0;
+    PointBuffer soa;
+    soa.assign(poly);
+    return polygonAreaSoA(soa);
 }
 
-int main() {
-    int numPoints;
-    if (!(cin >> numPoints) || numPoints <= 0) {
+int main(int argc, char* argv[]) {
+    // "CH file" maps the file and parses it on every core; otherwise stdin
+    vector<Point> points;
+    PointLoad load = argc > 1 ? mapPointFile(argv[1], points) : readPointStream(0, points);
+    switch (load.status) {
+    case PointParser::OPEN:
+        cerr << "Error: Cannot read " << argv[1] << "." << endl;
+        return 1;
+    case PointParser::COUNT:
         cerr << "Error: Invalid number of points." << endl;
         return 1;
+    case PointParser::END:
+        cerr << "Error: Not enough input lines." << endl;
+        return 1;
+    case PointParser::INVALID:
+        cerr << "Error: Invalid point format at line " << load.line << "." << endl;
+        return 1;
+    case PointParser::EXTRA:
+        cerr << "Error: Extra data in line " << load.line << "." << endl;
+        return 1;
+    case PointParser::OK:
+        break;
     }
-    cin.ignore(); 
+    int numPoints = points.size();
 
-    vector<Point> points;
-    for (int i = 0; i < numPoints; ++i) {
-        string line;
-        if (!getline(cin, line)) {
-            cerr << "Error: Not enough input lines." << endl;
-            return 1;
-        }
-
-        replace(line.begin(), line.end(), ',', ' ');
-
-        stringstream ss(line);
-        Point p;
-        if (!(ss >> p.x >> p.y)) {
-            cerr << "Error: Invalid point format at line " << i + 1 << "." << endl;
-            return 1;
-        }
-
-        string extra;
-        if (ss >> extra) {
-            cerr << "Error: Extra data in line " << i + 1 << "." << endl;
-            return 1;
-        }
-
-        points.push_back(p);
-    }
+    // Interior points are culled once, both engines sort only the survivors
+    auto start0 = chrono::high_resolution_clock::now();
+    size_t discarded = aklToussaintFilter(points);
+    auto end0 = chrono::high_resolution_clock::now();
+    chrono::duration<double> diff0 = end0 - start0;
 
     auto start1 = chrono::high_resolution_clock::now();
-    auto hull1 = convexHullDeque(points);
+    auto hull1 = dequeHull(points);
     auto end1 = chrono::high_resolution_clock::now();
     chrono::duration<double> diff1 = end1 - start1;
 
@@ -121,6 +97,19 @@ int main() {
     auto end2 = chrono::high_resolution_clock::now();
     chrono::duration<double> diff2 = end2 - start2;
 
+    // Sub-hulls on every core, merged; small inputs take the sequential path
+    auto start3 = chrono::high_resolution_clock::now();
+    auto hull3 = parallelHull<Point>(points);
+    auto end3 = chrono::high_resolution_clock::now();
+    chrono::duration<double> diff3 = end3 - start3;
+
+    // Output-sensitive O(n log h), seeded with the sampled hull-size estimate
+    auto start4 = chrono::high_resolution_clock::now();
+    auto hull4 = chanHull(points, estimateHullSize(points));
+    auto end4 = chrono::high_resolution_clock::now();
+    chrono::duration<double> diff4 = end4 - start4;
+
+    cout << "Filter: discarded " << discarded << " of " << numPoints << " points  Duration: " << diff0.count() << " s\n";
 
     float area1 = polygonArea(hull1);
     cout << "Deque: " << area1  << "    Duration: " << diff1.count() << " s\n";
@@ -128,5 +117,11 @@ int main() {
     float area2 = polygonArea(hull2);
     cout << "Vector: " << area2 << "   Duration: " << diff2.count() << " s\n";
 
+    float area3 = polygonArea(hull3);
+    cout << "Parallel: " << area3 << " Duration: " << diff3.count() << " s\n";
+
+    float area4 = polygonArea(hull4);
+    cout << "Chan: " << area4 << "     Duration: " << diff4.count() << " s\n";
+
     return 0;
 }
@@ -3,8 +3,12 @@
 #include <algorithm>
 #include <cmath>
 #include <sstream>
-#include <deque>
 #include <chrono>
+#include "../common/PointStore.hpp"
+#include "../common/HullFilter.hpp"
+#include "../common/SimdKernels.hpp"
+#include "../common/PointParser.hpp"
+#include "../common/HullEngines.hpp"
 
 using namespace std;
 
@@ -16,47 +20,20 @@ struct Point {
     }
 };
 
-// Cross product
-float cross(const Point &O, const Point &A, const Point &B) {
-    return (A.x - O.x)*(B.y - O.y) - (A.y - O.y)*(B.x - O.x);
-}
-
-
-vector<Point> convexHullDeque(vector<Point> P) {
-    int n = P.size();
-    sort(P.begin(), P.end());
-    deque<Point> hull;
-
-    for (int i = 0; i < n; i++) {
-        while (hull.size() >= 2 && cross(hull[hull.size()-2], hull.back(), P[i]) <= 0)
-            hull.pop_back();
-        hull.push_back(P[i]);
-    }
-
-    long unsigned int t = hull.size() + 1;
-    for (int i = n - 2; i >= 0; i--) {
-        while (hull.size() >= t && cross(hull[hull.size()-2], hull.back(), P[i]) <= 0)
-            hull.pop_back();
-        hull.push_back(P[i]);
-    }
-
-    hull.pop_back(); // remove duplicate
-    return vector<Point>(hull.begin(), hull.end());
-}
-
 // Calculate polygon area
 float polygonArea(const vector<Point> &poly) {
-    float area = 0;
-    int n = poly.size();
-    for (int i = 0; i < n; ++i) {
-        area += poly[i].x * poly[(i+1)%n].y - poly[i].y * poly[(i+1)%n].x;
-    }
-    return abs(area) / 2.0;
+    PointBuffer soa;
+    soa.assign(poly);
+    return polygonAreaSoA(soa);
 }
 
 int main() {
-    vector<Point> points;
+    PointStore<Point> points(0.0); // Removepoint matches exactly
     string line;
+    // Every change bumps version; CH recomputes only when it moved
+    unsigned long version = 0, cached_version = 0;
+    float cached_area = 0;
+    unsigned long hits = 0, misses = 0;
 
     while (getline(cin, line)) {
         stringstream ss(line);
@@ -67,6 +44,7 @@ int main() {
             int n;
             ss >> n;
             points.clear();
+            version++;
 
             for (int i = 0; i < n; ++i) {
                 if (!getline(cin, line)) {
@@ -80,25 +58,50 @@ int main() {
                 pointStream >> p.x >> p.y;
                 points.push_back(p);
             }
+        } else if (command == "Loadgraph") {
+            // "Loadgraph file" replaces the graph with a text or binary
+            // point file; on error the current graph is kept
+            string path;
+            ss >> path;
+            vector<Point> loaded;
+            PointLoad load = mapPointFile(path.c_str(), loaded);
+            if (load.status != PointParser::OK) {
+                cerr << "Error: Cannot load " << path << " (";
+                if (load.status == PointParser::OPEN) cerr << "unreadable";
+                else if (load.status == PointParser::COUNT) cerr << "invalid number of points";
+                else if (load.status == PointParser::END) cerr << "not enough input lines";
+                else cerr << "bad line " << load.line;
+                cerr << ")." << endl;
+                continue;
+            }
+            points.clear();
+            points.reserve(loaded.size());
+            for (const Point& p : loaded) points.push_back(p);
+            version++;
         } else if (command == "CH") {
-            auto hull1 = convexHullDeque(points);
-
-            float area1 = polygonArea(hull1);
-            cout << area1 << endl;
+            if (cached_version == version) {
+                hits++;
+            } else {
+                misses++;
+                vector<Point> candidates = points.toVector();
+                aklToussaintFilter(candidates);
+                auto hull1 = dequeHull(candidates);
+                cached_area = polygonArea(hull1);
+                cached_version = version;
+            }
+            cout << cached_area << endl;
 
+        } else if (command == "Stats") {
+            cout << "CH cache: " << hits << " hits, " << misses << " misses" << endl;
         } else if (command == "Newpoint") {
             float x, y;
             ss >> x >> y;
             points.push_back({x, y});
+            version++;
         } else if (command == "Removepoint") {
             float x, y;
             ss >> x >> y;
-            auto it = remove_if(points.begin(), points.end(), [x, y](const Point& p) {
-                return p.x == x && p.y == y;
-            });
-            if (it != points.end()) {
-                points.erase(it, points.end());
-            }
+            if (points.removeAll(x, y) > 0) version++;
         }
     }
 
@@ -2,9 +2,8 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
-#include <sstream>
-#include <deque>
 #include <string>
+#include <map>
 #include <cstring>
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -13,6 +12,11 @@
 #include <poll.h>
 #include <errno.h>
 #include <netdb.h>
+#include "../common/IncrementalHull.hpp"
+#include "../common/PointStore.hpp"
+#include "../common/LineBuffer.hpp"
+#include "../common/ReplyBuffer.hpp"
+#include "../common/GraphRegistry.hpp"
 
 using namespace std;
 
@@ -26,50 +30,24 @@ struct Point {
     }
 };
 
-// Global graph data structure shared by all clients
-vector<Point> global_points;
-
-// Cross product
-float cross(const Point &O, const Point &A, const Point &B) {
-    return (A.x - O.x)*(B.y - O.y) - (A.y - O.y)*(B.x - O.x);
-}
-
-// Convex Hull algorithm using deque
-vector<Point> convexHullDeque(vector<Point> P) {
-    int n = P.size();
-    if (n < 3) return P;
-    
-    sort(P.begin(), P.end());
-    deque<Point> hull;
-
-    for (int i = 0; i < n; i++) {
-        while (hull.size() >= 2 && cross(hull[hull.size()-2], hull.back(), P[i]) <= 0)
-            hull.pop_back();
-        hull.push_back(P[i]);
-    }
-
-    long unsigned int t = hull.size() + 1;
-    for (int i = n - 2; i >= 0; i--) {
-        while (hull.size() >= t && cross(hull[hull.size()-2], hull.back(), P[i]) <= 0)
-            hull.pop_back();
-        hull.push_back(P[i]);
-    }
+// One loop serves every client, so CH reads the hull cache directly and no
+// snapshot is ever published
+struct NoSnapshot {
+    unsigned long version;
+    NoSnapshot() : version(0) {}
+};
 
-    hull.pop_back(); // remove duplicate
-    return vector<Point>(hull.begin(), hull.end());
-}
+// Named graphs (see GraphRegistry.hpp); their mutexes go unused here. Points
+// match within 0.0001, the same tolerance as Removepoint
+typedef NamedGraph<Point, NoSnapshot> Graph;
+GraphRegistry<Graph> graphs(0.0001);
 
-// Calculate polygon area
-float polygonArea(const vector<Point> &poly) {
-    if (poly.size() < 3) return 0.0;
-    
-    float area = 0;
-    int n = poly.size();
-    for (int i = 0; i < n; ++i) {
-        area += poly[i].x * poly[(i+1)%n].y - poly[i].y * poly[(i+1)%n].x;
-    }
-    return abs(area) / 2.0;
-}
+struct Client {
+    LineBuffer input; // Bytes received that do not yet form a whole command
+    Graph* graph; // Graph this client works on
+    Client() : graph(graphs.get(GRAPH_DEFAULT_NAME)) {}
+};
+map<int, Client> clients;
 
 // Get sockaddr, IPv4 or IPv6
 void *get_in_addr(struct sockaddr *sa) {
@@ -149,57 +127,104 @@ void del_from_pfds(struct pollfd pfds[], int i, int *fd_count) {
     (*fd_count)--;
 }
 
-// Process client command
-string process_command(const string& command) {
-    stringstream ss(command);
-    string cmd;
-    ss >> cmd;
+// Process client command on its graph g; its reply is appended to reply
+void process_command(string_view command, Graph*& g, string& reply) {
+    string_view args = command;
+    string_view cmd = nextToken(args);
     
     if (cmd == "Newgraph") {
         int n;
-        ss >> n;
-        global_points.clear();
-        return "OK: New graph created with " + to_string(n) + " points expected\n";
+        if (!parseNewgraphArgs(graphs, args, g, n)) {
+            reply += "ERROR: Invalid Newgraph command format\n";
+            return;
+        }
+        if (!graphs.admit(g, max(n, 0))) {
+            reply += "ERROR: Graph memory limit reached\n";
+            return;
+        }
+        g->points.clear();
+        g->hull.reset();
+        g->changed();
+        reply += "OK: New graph created with ";
+        reply += to_string(n);
+        reply += " points expected\n";
+        
+    } else if (cmd == "Use") {
+        Graph* next = graphs.get(nextToken(args));
+        if (!next) {
+            reply += "ERROR: Invalid graph name\n";
+            return;
+        }
+        g = next;
+        reply += "OK: Using graph ";
+        reply += g->name;
+        reply += '\n';
         
     } else if (cmd == "CH") {
-        auto hull = convexHullDeque(global_points);
-        float area = polygonArea(hull);
-        return to_string(area) + "\n";
+        double area = g->hull.area(g->points);
+        g->account(); // A rebuild resizes the hull cache
+        reply += to_string(area);
+        reply += '\n';
+        
+    } else if (cmd == "Stats") {
+        // Hull cache counters, for tuning
+        size_t count, total;
+        graphs.totals(count, total);
+        char line[256];
+        snprintf(line, sizeof(line), "OK: Graph %s: %zu points, %zu bytes, CH cache %lu hits, %lu misses "
+                 "(%zu graphs, %zu bytes in all)\n", g->name.c_str(), g->points.size(), g->bytes.load(),
+                 g->hull.hits(), g->hull.misses(), count, total);
+        reply += line;
         
     } else if (cmd == "Newpoint") {
         float x, y;
-        char comma;
-        ss >> x >> comma >> y;
-        global_points.push_back({x, y});
-        return "OK: Point added\n";
+        if (!parseCoords(args, x, y)) {
+            reply += "ERROR: Invalid point format\n";
+            return;
+        }
+        if (!graphs.fits(1)) {
+            reply += "ERROR: Graph memory limit reached\n";
+            return;
+        }
+        g->points.push_back({x, y});
+        g->hull.insert(g->points.back());
+        g->changed();
+        reply += "OK: Point added\n";
         
     } else if (cmd == "Removepoint") {
         float x, y;
-        char comma;
-        ss >> x >> comma >> y;
-        auto it = remove_if(global_points.begin(), global_points.end(), 
-                           [x, y](const Point& p) {
-                               return abs(p.x - x) < 0.0001 && abs(p.y - y) < 0.0001;
-                           });
-        if (it != global_points.end()) {
-            global_points.erase(it, global_points.end());
-            return "OK: Point removed\n";
+        if (!parseCoords(args, x, y)) {
+            reply += "ERROR: Invalid point format\n";
+            return;
+        }
+        long idx;
+        size_t removed = 0;
+        while ((idx = g->points.find(x, y)) >= 0) {
+            g->hull.remove(g->points[idx]);
+            g->points.erase(idx);
+            removed++;
+        }
+        if (removed > 0) {
+            g->changed();
+            reply += "OK: Point removed\n";
         } else {
-            return "ERROR: Point not found\n";
+            reply += "ERROR: Point not found\n";
         }
     } else {
         // Handle point coordinates for Newgraph
         float x, y;
-        if (ss.str().find(',') != string::npos) {
-            string line = ss.str();
-            replace(line.begin(), line.end(), ',', ' ');
-            stringstream pointStream(line);
-            if (pointStream >> x >> y) {
-                global_points.push_back({x, y});
-                return "OK: Point added to graph\n";
+        if (parseCoords(command, x, y)) {
+            if (!graphs.fits(1)) {
+                reply += "ERROR: Graph memory limit reached\n";
+                return;
             }
+            g->points.push_back({x, y});
+            g->hull.insert(g->points.back());
+            g->changed();
+            reply += "OK: Point added to graph\n";
+            return;
         }
-        return "ERROR: Unknown command\n";
+        reply += "ERROR: Unknown command\n";
     }
 }
 
@@ -217,6 +242,7 @@ void handle_new_connection(int listener, int *fd_count, int *fd_size, struct pol
         perror("accept");
     } else {
         add_to_pfds(pfds, newfd, fd_count, fd_size);
+        clients[newfd] = Client();
         printf("CH Server: new connection from %s on socket %d\n",
                inet_ntop(remoteaddr.ss_family,
                         get_in_addr((struct sockaddr*)&remoteaddr),
@@ -227,39 +253,36 @@ void handle_new_connection(int listener, int *fd_count, int *fd_size, struct pol
 
 // Handle regular client data or client hangups
 void handle_client_data(int *fd_count, struct pollfd *pfds, int *pfd_i) {
-    char buf[1024]; // Buffer for client data
-    int nbytes = recv(pfds[*pfd_i].fd, buf, sizeof buf - 1, 0);
     int sender_fd = pfds[*pfd_i].fd;
+    Client& client = clients[sender_fd];
+    int nbytes = client.input.fill(sender_fd);
     
     if (nbytes <= 0) {
         // Got error or connection closed by client
         if (nbytes == 0) {
             // Connection closed
             printf("CH Server: socket %d hung up\n", sender_fd);
+        } else if (errno == EMSGSIZE) {
+            printf("CH Server: socket %d sent a line over %d bytes\n", sender_fd, LINE_BUFFER_CAPACITY);
         } else {
             perror("recv");
         }
         close(pfds[*pfd_i].fd); // Bye!
+        clients.erase(sender_fd);
         del_from_pfds(pfds, *pfd_i, fd_count);
         (*pfd_i)--; // Reexamine the slot we just deleted
         
     } else {
-        // We got some good data from a client
-        buf[nbytes] = '\0'; // Null terminate the string
-        
-        printf("CH Server: received from fd %d: %s", sender_fd, buf);
-        
-        // Process the command
-        string command(buf);
-        // Remove trailing newline if present
-        if (!command.empty() && command.back() == '\n') {
-            command.pop_back();
+        // A read may end mid-line or hold several pipelined commands: run
+        // every complete line and keep the rest for the next read
+        string reply;
+        string_view command;
+        while (client.input.nextLine(command)) {
+            process_command(command, client.graph, reply);
         }
         
-        string response = process_command(command);
-        
-        // Send response back to the client
-        if (send(sender_fd, response.c_str(), response.length(), 0) == -1) {
+        // One send for all the replies of this read
+        if (!reply.empty() && !flushReplies(sender_fd, reply)) {
             perror("send");
         }
     }
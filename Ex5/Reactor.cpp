@@ -1,138 +1,359 @@
-#ifndef REACTOR_HPP
-#define REACTOR_HPP
-
 #include <vector>
 #include <map>
-#include <sys/select.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <errno.h>
 #include <poll.h>
 #include <unistd.h>
 #include <algorithm>
 #include <cstring>
 #include <pthread.h>
 #include <stdio.h>
+#include <sched.h>
+#include <atomic>
 #include "Reactor.hpp"
 
-// Function pointer type for reactor callbacks
-typedef void* (*reactorFunc)(int fd);
+// Max events returned by a single epoll_wait call
+#define MAX_EVENTS 64
+
+// Registered fd: its read callback and the output not yet written to it
+struct FdEntry {
+    reactorFunc func;
+    std::string out;    // Queued output; bytes before head are already written
+    size_t head;
+    bool paused;        // Reading stopped: more than the high-water mark queued
+    bool broken;        // A write failed; the callback will see the close on read
+    uint32_t events;    // Interest currently registered with epoll
+
+    FdEntry() : func(nullptr), head(0), paused(false), broken(false), events(EPOLLIN) {}
+    size_t pending() const { return out.size() - head; }
+};
 
 // Reactor structure
 struct Reactor {
-    std::vector<int> fds;                    // List of file descriptors
-    std::map<int, reactorFunc> reactorFuncs; // Map fd -> function
+    int epoll_fd;                            // epoll instance, each fd is registered once
+    std::map<int, FdEntry> fds;              // Map fd -> callback and output queue
+    size_t high_water;                       // Pause reading above this much queued output (0 = never)
     bool running;                            // Reactor state
     pthread_t thread;                        // Thread running the reactor loop
-    pthread_mutex_t mutex;                   // Protect fds and reactorFuncs
+    pthread_mutex_t mutex;                   // Protect fds
 
-    Reactor() : running(false) {
+    Reactor() : epoll_fd(-1), high_water(REACTOR_HIGH_WATER), running(false) {
         pthread_mutex_init(&mutex, nullptr);
     }
     ~Reactor() {
+        if (epoll_fd != -1) close(epoll_fd);
         pthread_mutex_destroy(&mutex);
     }
 };
 
-// Internal reactor loop function (select)
-void* reactorFunction(void* reactor_ptr) {
-    Reactor* reactor = static_cast<Reactor*>(reactor_ptr);
-    while (reactor->running) {
-        if (reactor->fds.empty()) {
-            usleep(1000);
-            continue;
-        }
-
-        fd_set readfds;
-        FD_ZERO(&readfds);
-        int max_fd = 0;
+// Re-registers fd with epoll when its interest changed: read unless paused,
+// write while output is queued. Call with r->mutex held
+static void updateInterest(Reactor* r, int fd, FdEntry& e) {
+    uint32_t events = (e.paused ? 0 : EPOLLIN) | (e.pending() > 0 ? EPOLLOUT : 0);
+    if (events == e.events) return;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(r->epoll_fd, EPOLL_CTL_MOD, fd, &ev) == 0) e.events = events;
+}
 
-        pthread_mutex_lock(&reactor->mutex);
-        for (int fd : reactor->fds) {
-            FD_SET(fd, &readfds);
-            if (fd > max_fd) max_fd = fd;
+// Writes as much queued output as the socket takes without blocking, then
+// updates the pause state. Call with r->mutex held
+static void flushQueue(Reactor* r, int fd, FdEntry& e) {
+    while (e.pending() > 0) {
+        ssize_t n = send(fd, e.out.data() + e.head, e.pending(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n <= 0) {
+            // Peer gone: drop the output and let the read callback see the close
+            e.broken = true;
+            e.out.clear();
+            e.head = 0;
+            break;
         }
-        pthread_mutex_unlock(&reactor->mutex);
+        e.head += n;
+    }
+    if (e.pending() == 0) {
+        e.out.clear();
+        e.head = 0;
+    } else if (e.head > e.out.size() / 2) {
+        e.out.erase(0, e.head);
+        e.head = 0;
+    }
+    if (e.broken) e.paused = false;
+    else if (r->high_water > 0 && e.pending() > r->high_water) e.paused = true;
+    else if (e.paused && e.pending() <= r->high_water / 2) e.paused = false;
+    updateInterest(r, fd, e);
+}
 
-        struct timeval tv;
-        tv.tv_sec = 1;
-        tv.tv_usec = 0;
+// Internal reactor loop function (epoll)
+void* reactorFunction(void* reactor_ptr) {
+    Reactor* reactor = static_cast<Reactor*>(reactor_ptr);
+    struct epoll_event events[MAX_EVENTS];
 
-        int result = select(max_fd + 1, &readfds, NULL, NULL, &tv);
+    while (reactor->running) {
+        // Only ready fds come back, so a wakeup costs O(active) and not O(registered)
+        int result = epoll_wait(reactor->epoll_fd, events, MAX_EVENTS, 1000);
         if (result == -1) {
-            perror("select");
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
             break;
         } else if (result == 0) {
             continue;
         }
-        
-        // Copy fds to avoid holding the mutex while processing
-        pthread_mutex_lock(&reactor->mutex);
-        std::vector<int> fds_copy = reactor->fds;
-        pthread_mutex_unlock(&reactor->mutex);
-
-        for (int fd : fds_copy) {
-            if (FD_ISSET(fd, &readfds)) {
-                pthread_mutex_lock(&reactor->mutex);
-                auto it = reactor->reactorFuncs.find(fd);
-                reactorFunc func = (it != reactor->reactorFuncs.end()) ? it->second : nullptr;
-                pthread_mutex_unlock(&reactor->mutex);
-                if (func) func(fd);
+
+        for (int i = 0; i < result; i++) {
+            int fd = events[i].data.fd;
+            // A previous callback in this batch may have removed the fd
+            pthread_mutex_lock(&reactor->mutex);
+            auto it = reactor->fds.find(fd);
+            reactorFunc func = nullptr;
+            if (it != reactor->fds.end()) {
+                FdEntry& e = it->second;
+                if (events[i].events & EPOLLOUT) flushQueue(reactor, fd, e);
+                // A paused fd is only read again once its output drained
+                if (!e.paused && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) func = e.func;
             }
+            pthread_mutex_unlock(&reactor->mutex);
+            if (func) func(fd);
         }
     }
     return nullptr;
 }
 
-// Starts new reactor and returns pointer to it
-void* startReactor() {
+// Reactor pool: N independent event loops, every fd lives on exactly one of them
+struct ReactorPool {
+    std::vector<Reactor*> loops;  // One Reactor (epoll + thread) per shard
+    std::vector<int> loads;       // Number of fds registered on each shard
+    std::map<int, int> owner;     // Map fd -> shard index
+    reactorPolicy policy;         // Picks the shard for a newly added fd
+    pthread_mutex_t mutex;        // Protect loads and owner
+
+    ReactorPool() : policy(nullptr) {
+        pthread_mutex_init(&mutex, nullptr);
+    }
+    ~ReactorPool() {
+        pthread_mutex_destroy(&mutex);
+    }
+};
+
+// Round-robin shard policy
+int roundRobinPolicy(int fd, const int* loads, int nloops) {
+    (void)fd;
+    (void)loads;
+    static std::atomic<unsigned> next(0);
+    return next.fetch_add(1) % nloops;
+}
+
+// Least-loaded shard policy (fewest registered fds)
+int leastLoadedPolicy(int fd, const int* loads, int nloops) {
+    (void)fd;
+    int best = 0;
+    for (int i = 1; i < nloops; i++) {
+        if (loads[i] < loads[best]) best = i;
+    }
+    return best;
+}
+
+// Creates one event loop; pins it to cpu when cpu >= 0
+static Reactor* startLoop(int cpu) {
     Reactor* reactor = new Reactor();
+    reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (reactor->epoll_fd == -1) {
+        perror("epoll_create1");
+        delete reactor;
+        return nullptr;
+    }
     reactor->running = true;
     if (pthread_create(&reactor->thread, nullptr, reactorFunction, reactor) != 0) {
         delete reactor;
         return nullptr;
     }
-    return static_cast<void*>(reactor);
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (pthread_setaffinity_np(reactor->thread, sizeof(set), &set) != 0) {
+            fprintf(stderr, "reactor: could not pin loop to cpu %d\n", cpu);
+        }
+    }
+    return reactor;
 }
 
-// Adds fd to Reactor (for reading); returns 0 on success
-int addFdToReactor(void* reactor, int fd, reactorFunc func) {
-    if (reactor == nullptr || func == nullptr) return -1;
-    Reactor* r = static_cast<Reactor*>(reactor);
+// Stops one event loop and frees it
+static void stopLoop(Reactor* reactor) {
+    reactor->running = false;
+    pthread_join(reactor->thread, nullptr);
+    delete reactor;
+}
+
+// Starts a pool of nloops reactors (0 = one per core) and returns pointer to it
+void* startReactorPool(int nloops, reactorPolicy policy) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu < 1) ncpu = 1;
+    if (nloops <= 0) nloops = (int)ncpu;
+    if (policy == nullptr) policy = roundRobinPolicy;
+
+    ReactorPool* pool = new ReactorPool();
+    pool->policy = policy;
+    for (int i = 0; i < nloops; i++) {
+        // A single loop is left unpinned so it behaves like the plain reactor
+        Reactor* loop = startLoop(nloops > 1 ? (int)(i % ncpu) : -1);
+        if (loop == nullptr) {
+            for (Reactor* r : pool->loops) stopLoop(r);
+            delete pool;
+            return nullptr;
+        }
+        pool->loops.push_back(loop);
+        pool->loads.push_back(0);
+    }
+    return static_cast<void*>(pool);
+}
+
+// Starts new reactor and returns pointer to it
+void* startReactor() {
+    return startReactorPool(1, roundRobinPolicy);
+}
+
+// Registers fd on a single event loop
+static int addFdToLoop(Reactor* r, int fd, reactorFunc func) {
     pthread_mutex_lock(&r->mutex);
-    auto it = std::find(r->fds.begin(), r->fds.end(), fd);
-    if (it != r->fds.end()) {
+    if (r->fds.count(fd)) {
+        pthread_mutex_unlock(&r->mutex);
+        return -1;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        perror("epoll_ctl");
         pthread_mutex_unlock(&r->mutex);
         return -1;
     }
-    r->fds.push_back(fd);
-    r->reactorFuncs[fd] = func;
+    r->fds[fd].func = func;
     pthread_mutex_unlock(&r->mutex);
     return 0;
 }
 
-// Removes fd from reactor
-int removeFdFromReactor(void* reactor, int fd) {
-    if (reactor == nullptr) return -1;
-    Reactor* r = static_cast<Reactor*>(reactor);
+// Unregisters fd from a single event loop
+static int removeFdFromLoop(Reactor* r, int fd) {
     pthread_mutex_lock(&r->mutex);
-    auto it = std::find(r->fds.begin(), r->fds.end(), fd);
+    auto it = r->fds.find(fd);
     if (it == r->fds.end()) {
         pthread_mutex_unlock(&r->mutex);
         return -1;
     }
+    // Must happen before the caller closes fd, otherwise epoll keeps a stale entry.
+    // Output still queued is dropped with the entry
+    epoll_ctl(r->epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
     r->fds.erase(it);
-    r->reactorFuncs.erase(fd);
     pthread_mutex_unlock(&r->mutex);
     return 0;
 }
 
-// Stops reactor
-int stopReactor(void* reactor) {
-    if (reactor == nullptr) return -1;
-    Reactor* r = static_cast<Reactor*>(reactor);
-    r->running = false;
-    pthread_join(r->thread, nullptr);
-    delete r;
+// Adds fd to Reactor (for reading); the pool policy picks the loop. Returns 0 on success
+int addFdToReactor(void* reactor, int fd, reactorFunc func) {
+    if (reactor == nullptr || func == nullptr) return -1;
+    ReactorPool* pool = static_cast<ReactorPool*>(reactor);
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->owner.count(fd)) {
+        pthread_mutex_unlock(&pool->mutex);
+        return -1;
+    }
+    int nloops = (int)pool->loops.size();
+    int shard = pool->policy(fd, pool->loads.data(), nloops);
+    if (shard < 0 || shard >= nloops) shard = 0;
+    if (addFdToLoop(pool->loops[shard], fd, func) != 0) {
+        pthread_mutex_unlock(&pool->mutex);
+        return -1;
+    }
+    pool->owner[fd] = shard;
+    pool->loads[shard]++;
+    pthread_mutex_unlock(&pool->mutex);
     return 0;
 }
 
+// Removes fd from reactor
+int removeFdFromReactor(void* reactor, int fd) {
+    if (reactor == nullptr) return -1;
+    ReactorPool* pool = static_cast<ReactorPool*>(reactor);
+    pthread_mutex_lock(&pool->mutex);
+    auto it = pool->owner.find(fd);
+    if (it == pool->owner.end()) {
+        pthread_mutex_unlock(&pool->mutex);
+        return -1;
+    }
+    int shard = it->second;
+    pool->owner.erase(it);
+    pool->loads[shard]--;
+    int result = removeFdFromLoop(pool->loops[shard], fd);
+    pthread_mutex_unlock(&pool->mutex);
+    return result;
+}
+
+// Queues output for fd: writes what the socket takes now, the rest as it
+// becomes writable. Returns 0 on success
+int sendToReactor(void* reactor, int fd, const char* data, size_t len) {
+    if (reactor == nullptr) return -1;
+    ReactorPool* pool = static_cast<ReactorPool*>(reactor);
+    pthread_mutex_lock(&pool->mutex);
+    auto owner = pool->owner.find(fd);
+    if (owner == pool->owner.end()) {
+        pthread_mutex_unlock(&pool->mutex);
+        return -1;
+    }
+    Reactor* r = pool->loops[owner->second];
+    pthread_mutex_lock(&r->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+    int result = -1;
+    auto it = r->fds.find(fd);
+    if (it != r->fds.end() && !it->second.broken) {
+        it->second.out.append(data, len);
+        flushQueue(r, fd, it->second);
+        result = it->second.broken ? -1 : 0;
+    }
+    pthread_mutex_unlock(&r->mutex);
+    return result;
+}
+
+// Bytes queued for fd and not yet written
+size_t pendingOnReactor(void* reactor, int fd) {
+    if (reactor == nullptr) return 0;
+    ReactorPool* pool = static_cast<ReactorPool*>(reactor);
+    size_t pending = 0;
+    pthread_mutex_lock(&pool->mutex);
+    auto owner = pool->owner.find(fd);
+    if (owner != pool->owner.end()) {
+        Reactor* r = pool->loops[owner->second];
+        pthread_mutex_lock(&r->mutex);
+        auto it = r->fds.find(fd);
+        if (it != r->fds.end()) pending = it->second.pending();
+        pthread_mutex_unlock(&r->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return pending;
+}
 
-#endif // REACTOR_HPP
\ No newline at end of file
+// Sets the output high-water mark on every loop of the pool
+void setReactorHighWater(void* reactor, size_t bytes) {
+    if (reactor == nullptr) return;
+    ReactorPool* pool = static_cast<ReactorPool*>(reactor);
+    for (Reactor* r : pool->loops) {
+        pthread_mutex_lock(&r->mutex);
+        r->high_water = bytes;
+        pthread_mutex_unlock(&r->mutex);
+    }
+}
+
+// Stops reactor (every loop of the pool)
+int stopReactor(void* reactor) {
+    if (reactor == nullptr) return -1;
+    ReactorPool* pool = static_cast<ReactorPool*>(reactor);
+    for (Reactor* r : pool->loops) stopLoop(r);
+    delete pool;
+    return 0;
+}
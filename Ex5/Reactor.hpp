@@ -1,21 +1,51 @@
 #ifndef REACTOR_HPP
 #define REACTOR_HPP
 
+#include <cstddef>
+
 // Function pointer type for reactor callbacks
 typedef void* (*reactorFunc)(int fd);
 
+// Shard policy for a reactor pool: returns the loop index for a new fd,
+// given the number of fds currently registered on each of the nloops loops
+typedef int (*reactorPolicy)(int fd, const int* loads, int nloops);
+
+// Default output high-water mark: reading from an fd pauses while more than
+// this many bytes queued by sendToReactor are still unwritten
+#define REACTOR_HIGH_WATER (1 << 20)
+
 // Reactor structure declaration
 struct Reactor;
 
-// Starts new reactor and returns pointer to it
+// Built-in shard policies
+int roundRobinPolicy(int fd, const int* loads, int nloops);
+int leastLoadedPolicy(int fd, const int* loads, int nloops);
+
+// Starts new reactor and returns pointer to it (a pool with a single loop)
 void* startReactor();
 
-// Adds fd to Reactor (for reading); returns 0 on success
+// Starts a pool of nloops event loops pinned to cores (0 = one per core).
+// The returned pointer is used with the same add/remove/stop functions
+void* startReactorPool(int nloops, reactorPolicy policy);
+
+// Adds fd to Reactor (for reading); the pool policy picks the loop. Returns 0 on success
 int addFdToReactor(void* reactor, int fd, reactorFunc func);
 
 // Removes fd from reactor
 int removeFdFromReactor(void* reactor, int fd);
 
+// Queues len bytes for fd and writes what the socket accepts without
+// blocking; the rest is written by the loop when fd becomes writable, in
+// order. Returns 0 on success, -1 if fd is not registered or its peer is gone
+int sendToReactor(void* reactor, int fd, const char* data, size_t len);
+
+// Bytes queued for fd and not yet written
+size_t pendingOnReactor(void* reactor, int fd);
+
+// Sets the high-water mark (0 = unlimited). Above it the fd's callback is no
+// longer called for input; it resumes once the queue drains to half the mark
+void setReactorHighWater(void* reactor, size_t bytes);
+
 // Stops reactor
 int stopReactor(void* reactor);
 
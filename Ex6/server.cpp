@@ -1,16 +1,23 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <sstream>
 #include <algorithm>
 #include <cmath>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
 #include <cstring>
 #include <map>
+#include <pthread.h>
 #include "../Ex5/Reactor.hpp"
+#include "../common/IncrementalHull.hpp"
+#include "../common/PointStore.hpp"
+#include "../common/LineBuffer.hpp"
+#include "../common/EpochPtr.hpp"
+#include "../common/GraphRegistry.hpp"
 
 void* reactor_ptr = nullptr; // Global for removeFdFromReactor
 
@@ -26,92 +33,78 @@ struct Point {
     }
 };
 
-std::vector<Point> graph;
+// Immutable view of a graph, published by the first CH after a change
+// (see NamedGraph::current); CH reads it without taking the graph's mutex
+struct GraphSnapshot {
+    double area;
+    unsigned long version; // The graph's version it was made from
+    GraphSnapshot() : area(0.0), version(0) {}
+};
 
-// Cross product for orientation
-double cross(const Point& o, const Point& a, const Point& b) {
-    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
-}
+// Named graphs, each with its own mutex (see GraphRegistry.hpp), so loops
+// serving clients of different graphs never wait for each other; points
+// match within 1e-9, the same tolerance as Point::operator==
+typedef NamedGraph<Point, GraphSnapshot> Graph;
+GraphRegistry<Graph> graphs(1e-9);
 
-// Convex Hull using Graham Scan
-std::vector<Point> convexHull(std::vector<Point> points) {
-    if (points.size() <= 1) return points;
-    int min_idx = 0;
-    for (int i = 1; i < (int)points.size(); i++) {
-        if (points[i].y < points[min_idx].y || 
-            (points[i].y == points[min_idx].y && points[i].x < points[min_idx].x)) {
-            min_idx = i;
-        }
-    }
-    std::swap(points[0], points[min_idx]);
-    Point pivot = points[0];
-    std::sort(points.begin() + 1, points.end(), [&](const Point& a, const Point& b) {
-        double cross_prod = cross(pivot, a, b);
-        if (cross_prod == 0) {
-            double dist_a = (a.x - pivot.x) * (a.x - pivot.x) + (a.y - pivot.y) * (a.y - pivot.y);
-            double dist_b = (b.x - pivot.x) * (b.x - pivot.x) + (b.y - pivot.y) * (b.y - pivot.y);
-            return dist_a < dist_b;
-        }
-        return cross_prod > 0;
-    });
-    std::vector<Point> hull;
-    for (const Point& p : points) {
-        while (hull.size() >= 2 && cross(hull[hull.size()-2], hull[hull.size()-1], p) < 0) {
-            hull.pop_back();
-        }
-        hull.push_back(p);
-    }
-    return hull;
+// Publishes g's area as a new snapshot; call with g->mutex held
+void publishGraph(Graph* g) {
+    GraphSnapshot* snap = new GraphSnapshot();
+    snap->area = g->hull.area(g->points);
+    snap->version = g->version.load();
+    g->snapshot.publish(snap);
 }
 
-// Calculate area of convex hull
-double calculateArea(const std::vector<Point>& hull) {
-    if (hull.size() < 3) return 0.0;
-    double area = 0.0;
-    int n = hull.size();
-    for (int i = 0; i < n; i++) {
-        int j = (i + 1) % n;
-        area += hull[i].x * hull[j].y;
-        area -= hull[j].x * hull[i].y;
-    }
-    return std::abs(area) / 2.0;
-}
-
-// Client data structure
+// Client data structure; only the loop serving the fd touches it
 struct ClientData {
-    std::string buffer;
-    ClientData() {}
+    LineBuffer input; // Commands are framed in place, without copies
+    Graph* g; // Graph this client works on
+    // Points of a Newgraph still arriving. A loop serves many clients, so it
+    // never holds g->mutex between reads: the points are collected here and
+    // swapped into g once the last one arrived
+    PointStore<Point> loaded;
+    int points_remaining;
+    ClientData() : g(graphs.get(GRAPH_DEFAULT_NAME)), loaded(graphs.eps()), points_remaining(0) {}
 };
 std::map<int, ClientData> clients;
+pthread_mutex_t clients_mutex = PTHREAD_MUTEX_INITIALIZER; // Protects the map, not its entries
 
-struct ClientState {
-    bool waiting_for_points = false;
-    int points_remaining = 0;
-};
-std::map<int, ClientState> client_states;
+// Replaces client.g's points with the ones collected and rebuilds once;
+// returns the new size
+size_t commitUpload(ClientData& client) {
+    Graph* g = client.g;
+    pthread_mutex_lock(&g->mutex);
+    g->points.swap(client.loaded);
+    g->hull.reset();
+    g->hull.invalidate();
+    g->changed();
+    size_t count = g->points.size();
+    pthread_mutex_unlock(&g->mutex);
+    PointStore<Point> fresh(graphs.eps()); // The old points are freed here, unlocked
+    client.loaded.swap(fresh);
+    return count;
+}
 
-void processCommand(int client_fd, const std::string& command) {
-    std::istringstream iss(command);
-    std::string cmd;
-    iss >> cmd;
+// Runs one command; its reply is appended to reply
+void processCommand(ClientData& client, std::string_view command, std::string& reply) {
+    std::string_view args = command;
+    std::string_view cmd = nextToken(args);
+    Graph*& g = client.g;
+    double x, y;
 
-    if (client_states[client_fd].waiting_for_points) {
-        size_t comma_pos = command.find(',');
-        if (comma_pos != std::string::npos) {
-            try {
-                double x = std::stod(command.substr(0, comma_pos));
-                double y = std::stod(command.substr(comma_pos + 1));
-                graph.push_back(Point(x, y));
-                client_states[client_fd].points_remaining--;
-                if (client_states[client_fd].points_remaining == 0) {
-                    client_states[client_fd].waiting_for_points = false;
-                    std::string response = "Graph created with " + std::to_string(graph.size()) + " points\n";
-                    send(client_fd, response.c_str(), response.length(), 0);
+    if (client.points_remaining > 0) {
+        if (command.find(',') != std::string_view::npos) {
+            if (parseCoords(command, x, y)) {
+                client.loaded.push_back(Point(x, y));
+                if (--client.points_remaining == 0) {
+                    reply += "Graph created with ";
+                    reply += std::to_string(commitUpload(client));
+                    reply += " points\n";
                 }
-            } catch (...) {
-                std::string error = "Invalid point format\n";
-                send(client_fd, error.c_str(), error.length(), 0);
-                client_states[client_fd].waiting_for_points = false;
+            } else {
+                reply += "Invalid point format\n";
+                client.points_remaining = 0;
+                commitUpload(client);
             }
         }
         return;
@@ -119,114 +112,128 @@ void processCommand(int client_fd, const std::string& command) {
 
     if (cmd == "Newgraph") {
         int n;
-        if (iss >> n) {
-            graph.clear();
-            if (n > 0) {
-                client_states[client_fd].waiting_for_points = true;
-                client_states[client_fd].points_remaining = n;
-                std::string response = "Ready to receive " + std::to_string(n) + " points. Send them as x,y format:\n";
-                send(client_fd, response.c_str(), response.length(), 0);
-            } else {
-                std::string response = "Empty graph created\n";
-                send(client_fd, response.c_str(), response.length(), 0);
-            }
+        if (!parseNewgraphArgs(graphs, args, g, n)) {
+            reply += "Invalid Newgraph command format\n";
+        } else if (!graphs.admit(g, std::max(n, 0))) {
+            reply += "Graph memory limit reached\n";
+        } else if (n > 0) {
+            client.points_remaining = n;
+            reply += "Ready to receive ";
+            reply += std::to_string(n);
+            reply += " points. Send them as x,y format:\n";
         } else {
-            std::string error = "Invalid Newgraph command format\n";
-            send(client_fd, error.c_str(), error.length(), 0);
+            commitUpload(client);
+            reply += "Empty graph created\n";
+        }
+    } else if (cmd == "Use") {
+        Graph* next = graphs.get(nextToken(args));
+        if (next) {
+            g = next;
+            reply += "Using graph ";
+            reply += g->name;
+            reply += '\n';
+        } else {
+            reply += "Invalid graph name\n";
         }
     } else if (cmd == "CH") {
-        std::vector<Point> hull = convexHull(graph);
-        double area = calculateArea(hull);
-        std::string response = std::to_string(area) + "\n";
-        send(client_fd, response.c_str(), response.length(), 0);
+        // Lock-free unless the graph changed since the last CH
+        double area = g->current(publishGraph, [](const GraphSnapshot& s) { return s.area; });
+        reply += std::to_string(area);
+        reply += '\n';
+    } else if (cmd == "Stats") {
+        size_t count, total;
+        graphs.totals(count, total);
+        char line[320];
+        snprintf(line, sizeof(line), "Graph %s: %zu points, %zu bytes, version %lu, CH cache %lu hits, "
+                 "%lu misses, %lu shared (%zu graphs, %zu bytes in all)\n", g->name.c_str(),
+                 g->size.load(), g->bytes.load(), g->version.load(), g->hits.load(), g->misses.load(),
+                 g->shared.load(), count, total);
+        reply += line;
     } else if (cmd == "Newpoint") {
-        std::string coords;
-        iss >> coords;
-        size_t comma_pos = coords.find(',');
-        if (comma_pos != std::string::npos) {
-            try {
-                double x = std::stod(coords.substr(0, comma_pos));
-                double y = std::stod(coords.substr(comma_pos + 1));
-                graph.push_back(Point(x, y));
-                std::string response = "Point added\n";
-                send(client_fd, response.c_str(), response.length(), 0);
-            } catch (...) {
-                std::string error = "Invalid point format\n";
-                send(client_fd, error.c_str(), error.length(), 0);
+        if (parseCoords(nextToken(args), x, y)) {
+            if (!graphs.fits(1)) {
+                reply += "Graph memory limit reached\n";
+                return;
             }
+            pthread_mutex_lock(&g->mutex);
+            g->points.push_back(Point(x, y));
+            g->hull.insert(g->points.back());
+            g->changed();
+            pthread_mutex_unlock(&g->mutex);
+            reply += "Point added\n";
         } else {
-            std::string error = "Invalid point format\n";
-            send(client_fd, error.c_str(), error.length(), 0);
+            reply += "Invalid point format\n";
         }
     } else if (cmd == "Removepoint") {
-        std::string coords;
-        iss >> coords;
-        size_t comma_pos = coords.find(',');
-        if (comma_pos != std::string::npos) {
-            try {
-                double x = std::stod(coords.substr(0, comma_pos));
-                double y = std::stod(coords.substr(comma_pos + 1));
-                auto it = std::find(graph.begin(), graph.end(), Point(x, y));
-                if (it != graph.end()) {
-                    graph.erase(it);
-                    std::string response = "Point removed\n";
-                    send(client_fd, response.c_str(), response.length(), 0);
-                } else {
-                    std::string response = "Point not found\n";
-                    send(client_fd, response.c_str(), response.length(), 0);
-                }
-            } catch (...) {
-                std::string error = "Invalid point format\n";
-                send(client_fd, error.c_str(), error.length(), 0);
+        if (parseCoords(nextToken(args), x, y)) {
+            pthread_mutex_lock(&g->mutex);
+            long idx = g->points.find(x, y);
+            if (idx >= 0) {
+                g->hull.remove(g->points[idx]);
+                g->points.erase(idx);
+                g->changed();
+                reply += "Point removed\n";
+            } else {
+                reply += "Point not found\n";
             }
+            pthread_mutex_unlock(&g->mutex);
         } else {
-            std::string error = "Invalid point format\n";
-            send(client_fd, error.c_str(), error.length(), 0);
+            reply += "Invalid point format\n";
         }
     } else {
-        size_t comma_pos = command.find(',');
-        if (comma_pos != std::string::npos) {
-            try {
-                double x = std::stod(command.substr(0, comma_pos));
-                double y = std::stod(command.substr(comma_pos + 1));
-                graph.push_back(Point(x, y));
-                std::string response = "Point added\n";
-                send(client_fd, response.c_str(), response.length(), 0);
-            } catch (...) {
-                std::string error = "Unknown command or invalid format\n";
-                send(client_fd, error.c_str(), error.length(), 0);
+        if (command.find(',') != std::string_view::npos) {
+            if (parseCoords(command, x, y)) {
+                if (!graphs.fits(1)) {
+                    reply += "Graph memory limit reached\n";
+                    return;
+                }
+                pthread_mutex_lock(&g->mutex);
+                g->points.push_back(Point(x, y));
+                g->hull.insert(g->points.back());
+                g->changed();
+                pthread_mutex_unlock(&g->mutex);
+                reply += "Point added\n";
+            } else {
+                reply += "Unknown command or invalid format\n";
             }
         } else {
-            std::string error = "Unknown command\n";
-            send(client_fd, error.c_str(), error.length(), 0);
+            reply += "Unknown command\n";
         }
     }
 }
 
 void* clientCallback(int client_fd) {
-    char buffer[1024];
-    ssize_t bytes = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
+    // Only this fd's loop touches its entry, and map nodes never move, so
+    // everything below runs without clients_mutex
+    pthread_mutex_lock(&clients_mutex);
+    ClientData& client = clients[client_fd];
+    pthread_mutex_unlock(&clients_mutex);
+    ssize_t bytes = client.input.fill(client_fd);
+    if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return nullptr;
     if (bytes <= 0) {
         if (bytes == 0) {
             std::cout << "Client " << client_fd << " disconnected normally\n";
+        } else if (errno == EMSGSIZE) {
+            std::cout << "Client " << client_fd << " sent a line over " << LINE_BUFFER_CAPACITY << " bytes\n";
         } else {
             perror("recv");
         }
+        // An unfinished upload is dropped with the entry
+        pthread_mutex_lock(&clients_mutex);
         clients.erase(client_fd);
-        client_states.erase(client_fd);
+        pthread_mutex_unlock(&clients_mutex);
         removeFdFromReactor(reactor_ptr, client_fd);
         close(client_fd);
         return nullptr;
     }
-    buffer[bytes] = '\0';
-    clients[client_fd].buffer += buffer;
-    size_t pos;
-    while ((pos = clients[client_fd].buffer.find('\n')) != std::string::npos) {
-        std::string command = clients[client_fd].buffer.substr(0, pos);
-        clients[client_fd].buffer.erase(0, pos + 1);
-        if (!command.empty() && command.back() == '\r') command.pop_back();
-        processCommand(client_fd, command);
+    std::string reply; // Replies to every complete command in this read
+    std::string_view command;
+    while (client.input.nextLine(command)) {
+        processCommand(client, command, reply);
     }
+    // One queued write for the whole batch. The reactor finishes it when the
+    // socket drains and stops reading this client while too much is pending
+    if (!reply.empty()) sendToReactor(reactor_ptr, client_fd, reply.data(), reply.size());
     return nullptr;
 }
 
@@ -239,7 +246,11 @@ void* acceptCallback(int listen_fd) {
         perror("accept");
         return nullptr;
     }
+    // Non-blocking: a client that stops reading can never stall the loop
+    fcntl(client_fd, F_SETFL, fcntl(client_fd, F_GETFL, 0) | O_NONBLOCK);
+    pthread_mutex_lock(&clients_mutex);
     clients[client_fd] = ClientData();
+    pthread_mutex_unlock(&clients_mutex);
     addFdToReactor(reactor_ptr, client_fd, clientCallback);
     std::cout << "New client connected: " << client_fd << "\n";
     return nullptr;
@@ -266,7 +277,13 @@ int main() {
         return 1;
     }
 
-    reactor_ptr = startReactor();
+    // One event loop per core; new clients go to the loop with the fewest fds
+    reactor_ptr = startReactorPool(0, leastLoadedPolicy);
+    if (reactor_ptr == nullptr) {
+        std::cerr << "Failed to start reactor\n";
+        close(listen_fd);
+        return 1;
+    }
     addFdToReactor(reactor_ptr, listen_fd, acceptCallback);
 
     std::cout << "Server running on port 9034\n";
@@ -7,6 +7,9 @@
 #include <unistd.h>
 #include <netdb.h>
 #include <thread>
+#include <vector>
+#include "../common/PointFile.hpp"
+#include "../common/BinaryGraph.hpp"
 
 using namespace std;
 
@@ -88,6 +91,54 @@ void receive_messages(int sockfd) {
     }
 }
 
+// Send all of data, retrying short writes
+bool send_all(int sockfd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t sent = send(sockfd, data, len, 0);
+        if (sent == -1) {
+            perror("send");
+            return false;
+        }
+        data += sent;
+        len -= sent;
+    }
+    return true;
+}
+
+// Load a binary point file (see pointconv) and upload it with Newgraph-binary
+bool send_binary_graph(int sockfd, const string& path) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        cerr << "Cannot read " << path << endl;
+        return true;
+    }
+    vector<char> data;
+    char chunk[1 << 16];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), f)) > 0) data.insert(data.end(), chunk, chunk + got);
+    fclose(f);
+
+    PointFileHeader h;
+    if (!readPointFileHeader(data.data(), data.size(), h) || h.count > (uint64_t)BINARY_GRAPH_MAX_POINTS ||
+        pointFileCapacity(h, data.size()) < h.count) {
+        cerr << path << " is not a valid binary point file" << endl;
+        return true;
+    }
+    struct XY { double x, y; };
+    vector<XY> points(h.count);
+    decodePointFile(data.data(), h, points.data());
+
+    // The wire carries little-endian float64 pairs
+    vector<char> payload(points.size() * 2 * sizeof(double));
+    for (size_t i = 0; i < points.size(); i++) {
+        pointfile_detail::store<double>(&payload[16 * i], points[i].x);
+        pointfile_detail::store<double>(&payload[16 * i + 8], points[i].y);
+    }
+    string command = string(BINARY_GRAPH_COMMAND) + " " + to_string(points.size()) + "\n";
+    return send_all(sockfd, command.c_str(), command.length()) &&
+           send_all(sockfd, payload.data(), payload.size());
+}
+
 // Interactive mode - user can type commands
 void interactive_mode(int sockfd) {
     string line;
@@ -97,6 +148,7 @@ void interactive_mode(int sockfd) {
     cout << "  x,y               - Add point (x,y) to current graph" << endl;
     cout << "  Newpoint x,y      - Add new point (x,y)" << endl;
     cout << "  Removepoint x,y   - Remove point (x,y)" << endl;
+    cout << "  Sendgraph file    - Upload a binary point file as a new graph" << endl;
     cout << "  CH                - Calculate convex hull area" << endl;
     cout << "  quit              - Exit client" << endl << endl;
     
@@ -113,6 +165,11 @@ void interactive_mode(int sockfd) {
             continue;
         }
         
+        if (line.compare(0, 10, "Sendgraph ") == 0) {
+            if (!send_binary_graph(sockfd, line.substr(10))) break;
+            continue;
+        }
+        
         // Send command to server
         line += "\n";
         if (send(sockfd, line.c_str(), line.length(), 0) == -1) {
@@ -1,7 +1,6 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <sstream>
 #include <algorithm>
 #include <cmath>
 #include <sys/socket.h>
@@ -9,9 +8,17 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
+#include <cerrno>
 #include <map>
 #include <set>
 #include <pthread.h>
+#include "../common/IncrementalHull.hpp"
+#include "../common/PointStore.hpp"
+#include "../common/EpochPtr.hpp"
+#include "../common/BinaryGraph.hpp"
+#include "../common/ReplyBuffer.hpp"
+#include "../common/LineBuffer.hpp"
+#include "../common/GraphRegistry.hpp"
 
 // Point structure
 struct Point {
@@ -27,54 +34,42 @@ struct Point {
 };
 
 // Global variables
-std::vector<Point> graph;
-pthread_mutex_t graph_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Immutable view of a graph, published by the first CH after a change
+// (see NamedGraph::current); CH reads it without taking the graph's mutex
+struct GraphSnapshot {
+    std::vector<Point> hull;
+    double area;
+    unsigned long version; // The graph's version it was made from
+    GraphSnapshot() : area(0.0), version(0) {}
+};
 
-// Helper functions for convex hull calculation
-double cross(const Point& O, const Point& A, const Point& B) {
-    return (A.x - O.x) * (B.y - O.y) - (A.y - O.y) * (B.x - O.x);
-}
+// Named graphs, each with its own mutex (see GraphRegistry.hpp); points
+// match within 1e-9, the same tolerance as Point::operator==
+typedef NamedGraph<Point, GraphSnapshot> Graph;
+GraphRegistry<Graph> graphs(1e-9);
 
-std::vector<Point> convexHull(std::vector<Point> points) {
-    if (points.size() <= 1) return points;
-    int min_idx = 0;
-    for (int i = 1; i < (int)points.size(); i++) {
-        if (points[i].y < points[min_idx].y || 
-            (points[i].y == points[min_idx].y && points[i].x < points[min_idx].x)) {
-            min_idx = i;
-        }
-    }
-    std::swap(points[0], points[min_idx]);
-    Point pivot = points[0];
-    std::sort(points.begin() + 1, points.end(), [&](const Point& a, const Point& b) {
-        double cross_prod = cross(pivot, a, b);
-        if (cross_prod == 0) {
-            double dist_a = (a.x - pivot.x) * (a.x - pivot.x) + (a.y - pivot.y) * (a.y - pivot.y);
-            double dist_b = (b.x - pivot.x) * (b.x - pivot.x) + (b.y - pivot.y) * (b.y - pivot.y);
-            return dist_a < dist_b;
-        }
-        return cross_prod > 0;
-    });
-    std::vector<Point> hull;
-    for (const Point& p : points) {
-        while (hull.size() >= 2 && cross(hull[hull.size()-2], hull[hull.size()-1], p) < 0) {
-            hull.pop_back();
-        }
-        hull.push_back(p);
-    }
-    return hull;
+// Publishes g's hull as a new snapshot; call with g->mutex held
+void publishGraph(Graph* g) {
+    GraphSnapshot* snap = new GraphSnapshot();
+    snap->hull = g->hull.hull(g->points);
+    snap->area = g->hull.area(g->points);
+    snap->version = g->version.load();
+    g->snapshot.publish(snap);
 }
 
-double calculateArea(const std::vector<Point>& hull) {
-    if (hull.size() < 3) return 0.0;
-    double area = 0.0;
-    int n = hull.size();
-    for (int i = 0; i < n; i++) {
-        int j = (i + 1) % n;
-        area += hull[i].x * hull[j].y;
-        area -= hull[j].x * hull[i].y;
-    }
-    return std::abs(area) / 2.0;
+// Replaces g's points with the ones in loaded and rebuilds once, on the next
+// CH; the old points are freed after g->mutex is released. Returns the new size
+size_t commitUpload(Graph* g, PointStore<Point>& loaded) {
+    pthread_mutex_lock(&g->mutex);
+    g->points.swap(loaded);
+    g->hull.reset();
+    g->hull.invalidate();
+    g->changed();
+    size_t count = g->points.size();
+    pthread_mutex_unlock(&g->mutex);
+    PointStore<Point> fresh(graphs.eps());
+    loaded.swap(fresh);
+    return count;
 }
 
 // struct for threads
@@ -87,141 +82,161 @@ void* handleClient(void* arg) {
     int client_fd = *((int*)arg);
     delete (int*)arg; // Free the memory
 
-    char buffer[1024];
-    std::string client_buffer;
-    bool waiting_for_points = false;
+    LineBuffer input; // Commands are framed in place, without copies
+    std::string reply; // Replies to the commands of one received batch
+    // Points of a Newgraph still arriving: collected here without g->mutex,
+    // so a slow uploader blocks nobody, and swapped into g once complete
+    PointStore<Point> loaded(graphs.eps());
     int points_remaining = 0;
+    Graph* g = graphs.get(GRAPH_DEFAULT_NAME); // Graph this connection works on
 
     while (true) {
-        ssize_t bytes = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
+        ssize_t bytes = input.fill(client_fd);
         if (bytes <= 0) {
             if (bytes == 0) {
                 std::cout << "Client " << client_fd << " disconnected normally\n";
+            } else if (errno == EMSGSIZE) {
+                std::cout << "Client " << client_fd << " sent a line over " << LINE_BUFFER_CAPACITY << " bytes\n";
             } else {
                 perror("recv");
             }
             break;
         }
-        buffer[bytes] = '\0';
-        client_buffer += buffer;
-        
-        size_t pos;
-        while ((pos = client_buffer.find('\n')) != std::string::npos) {
-            std::string command = client_buffer.substr(0, pos);
-            client_buffer.erase(0, pos + 1);
-            if (!command.empty() && command.back() == '\r') command.pop_back();
-            
-            std::istringstream iss(command);
-            std::string cmd;
-            iss >> cmd;
-            
-            if (waiting_for_points) {
-                size_t comma_pos = command.find(',');
-                if (comma_pos != std::string::npos) {
-                    try {
-                        double x = std::stod(command.substr(0, comma_pos));
-                        double y = std::stod(command.substr(comma_pos + 1));
-                        graph.push_back(Point(x, y));
-                        points_remaining--;
-                        if (points_remaining == 0) {
-                            waiting_for_points = false;
-                            std::string response = "Graph created with " + std::to_string(graph.size()) + " points\n";
-                            send(client_fd, response.c_str(), response.length(), 0);
-                            pthread_mutex_unlock(&graph_mutex);
+
+        std::string_view command;
+        while (input.nextLine(command)) {
+            std::string_view args = command;
+            std::string_view cmd = nextToken(args);
+            double x, y;
+
+            if (points_remaining > 0) {
+                if (command.find(',') != std::string_view::npos) {
+                    if (parseCoords(command, x, y)) {
+                        loaded.push_back(Point(x, y));
+                        if (--points_remaining == 0) {
+                            reply += "Graph created with ";
+                            reply += std::to_string(commitUpload(g, loaded));
+                            reply += " points\n";
                         }
-                    } catch (...) {
-                        std::string error = "Invalid point format\n";
-                        send(client_fd, error.c_str(), error.length(), 0);
-                        waiting_for_points = false;
-                        pthread_mutex_unlock(&graph_mutex);
+                    } else {
+                        reply += "Invalid point format\n";
+                        points_remaining = 0;
+                        commitUpload(g, loaded);
                     }
                 }
             }
+            else if (cmd == BINARY_GRAPH_COMMAND) {
+                long n;
+                if (!parseNewgraphArgs(graphs, args, g, n) || n < 0 || n > BINARY_GRAPH_MAX_POINTS) {
+                    reply += "Invalid Newgraph-binary command format\n";
+                    continue;
+                }
+                if (!graphs.admit(g, n)) {
+                    reply += "Graph memory limit reached\n";
+                    continue;
+                }
+                flushReplies(client_fd, reply); // Do not hold earlier replies during the upload
+                // The packed points follow the command line: read them straight
+                // off the socket into a store of our own, without g->mutex, so a
+                // stalled upload blocks nobody; then swap it in and rebuild once
+                if (!recvBinaryGraph(client_fd, input, n, loaded)) {
+                    std::cout << "Client " << client_fd << " disconnected during " << BINARY_GRAPH_COMMAND << "\n";
+                    close(client_fd);
+                    return nullptr;
+                }
+                size_t count = commitUpload(g, loaded);
+                reply += "Graph created with ";
+                reply += std::to_string(count);
+                reply += " points\n";
+            }
             else if (cmd == "Newgraph") {
-                pthread_mutex_lock(&graph_mutex);
                 int n;
-                if (iss >> n) {
-                    graph.clear();
+                if (parseNewgraphArgs(graphs, args, g, n)) {
+                    if (!graphs.admit(g, std::max(n, 0))) {
+                        reply += "Graph memory limit reached\n";
+                        continue;
+                    }
                     if (n > 0) {
-                        waiting_for_points = true;
                         points_remaining = n;
-                        std::string response = "Ready to receive " + std::to_string(n) + " points. Send them as x,y format:\n";
-                        send(client_fd, response.c_str(), response.length(), 0);
+                        reply += "Ready to receive ";
+                        reply += std::to_string(n);
+                        reply += " points. Send them as x,y format:\n";
                     } else {
-                        std::string response = "Empty graph created\n";
-                        send(client_fd, response.c_str(), response.length(), 0);
+                        commitUpload(g, loaded);
+                        reply += "Empty graph created\n";
                     }
                 } else {
-                    std::string error = "Invalid Newgraph command format\n";
-                    send(client_fd, error.c_str(), error.length(), 0);
+                    reply += "Invalid Newgraph command format\n";
                 }
             }
+            else if (cmd == "Use") {
+                Graph* next = graphs.get(nextToken(args));
+                if (next) {
+                    g = next;
+                    reply += "Using graph ";
+                    reply += g->name;
+                    reply += '\n';
+                } else {
+                    reply += "Invalid graph name\n";
+                }
+            }
+            else if (cmd == "Stats") {
+                size_t count, total;
+                graphs.totals(count, total);
+                char line[320];
+                snprintf(line, sizeof(line), "Graph %s: %zu points, %zu bytes, version %lu, CH cache %lu hits, "
+                         "%lu misses, %lu shared (%zu graphs, %zu bytes in all)\n", g->name.c_str(),
+                         g->size.load(), g->bytes.load(), g->version.load(), g->hits.load(), g->misses.load(),
+                         g->shared.load(), count, total);
+                reply += line;
+            }
             else if (cmd == "CH") {
-                pthread_mutex_lock(&graph_mutex);
-                std::vector<Point> hull = convexHull(graph);
-                double area = calculateArea(hull);
-                std::string response = std::to_string(area) + "\n";
-                send(client_fd, response.c_str(), response.length(), 0);
-                pthread_mutex_unlock(&graph_mutex);
+                // Lock-free unless the graph changed since the last CH; then
+                // one CH publishes and the ones arriving meanwhile share it
+                double area = g->current(publishGraph, [](const GraphSnapshot& s) { return s.area; });
+                reply += std::to_string(area);
+                reply += '\n';
             }
             else if (cmd == "Newpoint") {
-                pthread_mutex_lock(&graph_mutex);
-                std::string coords;
-                iss >> coords;
-                size_t comma_pos = coords.find(',');
-                if (comma_pos != std::string::npos) {
-                    try {
-                        double x = std::stod(coords.substr(0, comma_pos));
-                        double y = std::stod(coords.substr(comma_pos + 1));
-                        graph.push_back(Point(x, y));
-                        std::string response = "Point added\n";
-                        send(client_fd, response.c_str(), response.length(), 0);
-                    } catch (...) {
-                        std::string error = "Invalid point format\n";
-                        send(client_fd, error.c_str(), error.length(), 0);
-                        pthread_mutex_unlock(&graph_mutex);
+                if (parseCoords(nextToken(args), x, y)) {
+                    if (!graphs.fits(1)) {
+                        reply += "Graph memory limit reached\n";
+                        continue;
                     }
+                    pthread_mutex_lock(&g->mutex);
+                    g->points.push_back(Point(x, y));
+                    g->hull.insert(g->points.back());
+                    g->changed();
+                    pthread_mutex_unlock(&g->mutex);
+                    reply += "Point added\n";
                 } else {
-                    std::string error = "Invalid point format\n";
-                    send(client_fd, error.c_str(), error.length(), 0);
+                    reply += "Invalid point format\n";
                 }
-                pthread_mutex_unlock(&graph_mutex);
             }
             else if (cmd == "Removepoint") {
-                pthread_mutex_lock(&graph_mutex);
-                std::string coords;
-                iss >> coords;
-                size_t comma_pos = coords.find(',');
-                if (comma_pos != std::string::npos) {
-                    try {
-                        double x = std::stod(coords.substr(0, comma_pos));
-                        double y = std::stod(coords.substr(comma_pos + 1));
-                        auto it = std::find(graph.begin(), graph.end(), Point(x, y));
-                        if (it != graph.end()) {
-                            graph.erase(it);
-                            std::string response = "Point removed\n";
-                            send(client_fd, response.c_str(), response.length(), 0);
-                        } else {
-                            std::string response = "Point not found\n";
-                            send(client_fd, response.c_str(), response.length(), 0);
-                        }
-                    } catch (...) {
-                        std::string error = "Invalid point format\n";
-                        send(client_fd, error.c_str(), error.length(), 0);
-                        pthread_mutex_unlock(&graph_mutex);
+                if (parseCoords(nextToken(args), x, y)) {
+                    pthread_mutex_lock(&g->mutex);
+                    long idx = g->points.find(x, y);
+                    if (idx >= 0) {
+                        g->hull.remove(g->points[idx]);
+                        g->points.erase(idx);
+                        g->changed();
+                        reply += "Point removed\n";
+                    } else {
+                        reply += "Point not found\n";
                     }
+                    pthread_mutex_unlock(&g->mutex);
                 } else {
-                    std::string error = "Invalid point format\n";
-                    send(client_fd, error.c_str(), error.length(), 0);
+                    reply += "Invalid point format\n";
                 }
-                pthread_mutex_unlock(&graph_mutex);
             }
             else {
-                std::string error = "Unknown command\n";
-                send(client_fd, error.c_str(), error.length(), 0);
+                reply += "Unknown command\n";
             }
             
         }
+        // One send for everything this batch produced
+        flushReplies(client_fd, reply);
     }
     
     close(client_fd);
@@ -284,6 +299,5 @@ int main() {
     }
     
     close(listen_fd);
-    pthread_mutex_destroy(&graph_mutex);
     return 0;
 }
\ No newline at end of file
@@ -1,6 +1,3 @@
-#ifndef REACTOR_HPP
-#define REACTOR_HPP
-
 #include <vector>
 #include <map>
 #include <sys/select.h>
@@ -10,11 +7,17 @@
 #include <cstring>
 #include <pthread.h>
 #include <stdio.h>
+#include <string>
+#include <cerrno>
+#include <fcntl.h>
 #include "Reactor.hpp"
 #include <pthread.h>
 #include <unistd.h>
+#include <map>
 #include <set>
 #include <mutex>
+#include <atomic>
+#include <semaphore.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -22,49 +25,200 @@
 #include <iostream>
 using namespace std;
 
-// Function pointer type for reactor callbacks
-typedef void* (*reactorFunc)(int fd);
+// Output queued by sendToReactor is capped per fd at this many bytes
+#define REACTOR_MAX_PENDING (1 << 20)
 
-// פונקציית callback פר לקוח
-typedef void* (*proactorFunc)(int sockfd);
+// Registered fd: its read callback (none for write-only fds) and the output
+// not yet written to it
+struct FdEntry {
+    reactorFunc func;
+    std::string out;    // Queued output; bytes before head are already written
+    size_t head;
+    bool broken;        // Peer gone or too slow; output is dropped
+
+    FdEntry() : func(nullptr), head(0), broken(false) {}
+    size_t pending() const { return out.size() - head; }
+};
 
 // Reactor structure
 struct Reactor {
-    std::vector<int> fds;                    // List of file descriptors
-    std::map<int, reactorFunc> reactorFuncs; // Map fd -> function
+    std::map<int, FdEntry> fds;              // Map fd -> callback and output queue
     bool running;                            // Reactor state
     pthread_t thread;                        // Thread running the reactor loop
-    pthread_mutex_t mutex;                   // Protect fds and reactorFuncs
+    pthread_mutex_t mutex;                   // Protect fds
+    int wake[2];                             // Self-pipe: new output interrupts poll()
 
     Reactor() : running(false) {
         pthread_mutex_init(&mutex, nullptr);
+        wake[0] = wake[1] = -1;
     }
     ~Reactor() {
+        if (wake[0] >= 0) close(wake[0]);
+        if (wake[1] >= 0) close(wake[1]);
         pthread_mutex_destroy(&mutex);
     }
 };
 
+// Default number of proactor workers, see setProactorWorkers
+static int proactor_workers = 64;
+
+// While every worker is busy the pool grows, up to this many; connections
+// beyond that are refused
+#define PROACTOR_MAX_WORKERS 1024
+
+// Capacity of the accepted-fd queue (power of two, at least PROACTOR_MAX_WORKERS)
+#define PROACTOR_QUEUE_SIZE 1024
+
+// Bounded lock-free MPMC queue of accepted fds (Vyukov's sequence-per-cell design)
+struct FdQueue {
+    struct Cell {
+        std::atomic<size_t> seq;
+        int fd;
+    };
+    Cell* cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head; // Next cell to pop
+    alignas(64) std::atomic<size_t> tail; // Next cell to push
+
+    explicit FdQueue(size_t capacity) : cells(new Cell[capacity]), mask(capacity - 1), head(0), tail(0) {
+        for (size_t i = 0; i < capacity; i++) cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+    ~FdQueue() { delete[] cells; }
+
+    // Returns false when the queue is full
+    bool push(int fd) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells[pos & mask];
+            size_t seq = c.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.fd = fd;
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Returns false when the queue is empty
+    bool pop(int& fd) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells[pos & mask];
+            size_t seq = c.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    fd = c.fd;
+                    c.seq.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
 struct Proactor {
     int listener_fd;
     proactorFunc handlerFunc;
-    bool running;
-    pthread_t thread;
-    std::mutex graph_mutex;  // Protect shared resources
-    std::set<pthread_t> client_threads;
+    std::atomic<bool> running;
+    pthread_t thread;                 // Accept loop
+    FdQueue queue;                    // Accepted fds waiting for a worker
+    sem_t ready;                      // Counts fds in queue, workers sleep on it
+    int core;                         // Workers kept while idle
+    pthread_mutex_t mutex;            // Protects the fields below
+    pthread_cond_t exited;            // Signalled when a worker exits
+    int live;                         // Worker threads running
+    int idle;                         // Workers not serving or promised an fd
+    std::set<int> active;             // Fds being served, shut down by stopProactor
+
+    Proactor() : listener_fd(-1), handlerFunc(nullptr), running(false), queue(PROACTOR_QUEUE_SIZE),
+                 core(0), live(0), idle(0) {
+        sem_init(&ready, 0, 0);
+        pthread_mutex_init(&mutex, nullptr);
+        pthread_cond_init(&exited, nullptr);
+    }
+    ~Proactor() {
+        sem_destroy(&ready);
+        pthread_mutex_destroy(&mutex);
+        pthread_cond_destroy(&exited);
+    }
 };
 
-// Thread per connection
-void* handle_connection_thread(void* arg) {
-    auto* data = static_cast<std::pair<proactorFunc, int>*>(arg);
-    proactorFunc func = data->first;
-    int client_fd = data->second;
-    delete data;
+// Running proactors by accept thread id, so stopProactor can find its workers
+static std::map<pthread_t, Proactor*> proactors;
+static std::mutex proactors_mutex;
 
-    if (func) func(client_fd);
-    close(client_fd);
+// Sets the worker pool size for proactors started afterwards
+void setProactorWorkers(int n) {
+    if (n > 0) proactor_workers = n;
+}
+
+// Worker: takes accepted fds off the queue and runs the handler on each.
+// Workers above the core size exit once their connection ends
+void* proactor_worker(void* arg) {
+    Proactor* p = static_cast<Proactor*>(arg);
+
+    while (true) {
+        if (sem_wait(&p->ready) != 0) continue; // EINTR
+        if (!p->running) break;
+
+        int client_fd;
+        if (!p->queue.pop(client_fd)) continue;
+        pthread_mutex_lock(&p->mutex);
+        p->active.insert(client_fd);
+        if (!p->running) shutdown(client_fd, SHUT_RDWR); // Missed by stopWorkers
+        pthread_mutex_unlock(&p->mutex);
+        bool kept = p->handlerFunc && p->handlerFunc(client_fd) == PROACTOR_FD_KEPT;
+        pthread_mutex_lock(&p->mutex);
+        p->active.erase(client_fd);
+        if (!kept) close(client_fd);
+        bool leave = !p->running || p->live > p->core;
+        if (!leave) p->idle++;
+        pthread_mutex_unlock(&p->mutex);
+        if (leave) break;
+    }
+
+    pthread_mutex_lock(&p->mutex);
+    p->live--;
+    pthread_cond_signal(&p->exited);
+    pthread_mutex_unlock(&p->mutex);
     return nullptr;
 }
 
+// Starts a detached worker; call with p->mutex held
+static bool addWorker(Proactor* p) {
+    pthread_t tid;
+    if (pthread_create(&tid, nullptr, proactor_worker, p) != 0) {
+        perror("pthread_create");
+        return false;
+    }
+    pthread_detach(tid);
+    p->live++;
+    return true;
+}
+
+// Ends every worker once p->running is false: busy ones see their
+// connection shut down, idle ones are woken, and all exit
+static void stopWorkers(Proactor* p) {
+    p->running = false;
+    pthread_mutex_lock(&p->mutex);
+    for (int fd : p->active) shutdown(fd, SHUT_RDWR);
+    for (int i = 0; i < p->live; i++) sem_post(&p->ready);
+    while (p->live > 0) pthread_cond_wait(&p->exited, &p->mutex);
+    pthread_mutex_unlock(&p->mutex);
+}
+
 void* proactor_loop(void* arg) {
     Proactor* p = static_cast<Proactor*>(arg);
 
@@ -74,21 +228,32 @@ void* proactor_loop(void* arg) {
 
         int client_fd = accept(p->listener_fd, (struct sockaddr*)&client_addr, &client_len);
         if (client_fd < 0) {
+            if (!p->running) break; // stopProactor shut the listener down
             perror("accept");
             continue;
         }
         std::cout << "New client accepted, fd: " << client_fd << std::endl;
 
-        pthread_t tid;
-        auto* args = new std::pair<proactorFunc, int>(p->handlerFunc, client_fd);
-        if (pthread_create(&tid, nullptr, handle_connection_thread, args) == 0) {
-            std::lock_guard<std::mutex> lock(p->graph_mutex);
-            p->client_threads.insert(tid);
-        } else {
-            perror("pthread_create");
-            delete args;
+        // Promise the fd to an idle worker, or to a new one while all are busy
+        pthread_mutex_lock(&p->mutex);
+        bool served = false;
+        if (p->idle > 0) {
+            p->idle--;
+            served = true;
+        } else if (p->live < PROACTOR_MAX_WORKERS) {
+            served = addWorker(p);
+        }
+        pthread_mutex_unlock(&p->mutex);
+
+        if (!served) {
+            std::cout << "All " << PROACTOR_MAX_WORKERS << " workers busy, refusing fd " << client_fd << std::endl;
+            send(client_fd, "Server busy\n", 12, MSG_DONTWAIT | MSG_NOSIGNAL);
             close(client_fd);
+            continue;
         }
+        // Every queued fd has a worker promised, so the queue never fills
+        p->queue.push(client_fd);
+        sem_post(&p->ready);
     }
 
     return nullptr;
@@ -100,78 +265,132 @@ pthread_t startProactor(int sockfd, proactorFunc threadFunc) {
     p->listener_fd = sockfd;
     p->handlerFunc = threadFunc;
     p->running = true;
+    p->core = std::min(proactor_workers, PROACTOR_MAX_WORKERS);
+
+    pthread_mutex_lock(&p->mutex);
+    for (int i = 0; i < p->core && addWorker(p); i++) {}
+    p->idle = p->live;
+    pthread_mutex_unlock(&p->mutex);
+    if (p->live == 0) {
+        delete p;
+        return 0;
+    }
 
     if (pthread_create(&p->thread, nullptr, proactor_loop, p) != 0) {
         perror("pthread_create");
+        stopWorkers(p);
         delete p;
         return 0;
     }
 
+    std::lock_guard<std::mutex> lock(proactors_mutex);
+    proactors[p->thread] = p;
     return p->thread;
 }
 
-// Stop the proactor by thread id
+// Stop the proactor by thread id. Nothing is cancelled: the listener and
+// every connection being served are shut down, so accept() and the
+// handlers' recv() return and each thread leaves through its normal path
 int stopProactor(pthread_t tid) {
-
-    if (pthread_cancel(tid) != 0) {
-        perror("pthread_cancel");
-        return -1;
+    Proactor* p = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(proactors_mutex);
+        auto it = proactors.find(tid);
+        if (it != proactors.end()) {
+            p = it->second;
+            proactors.erase(it);
+        }
     }
+    if (!p) return -1;
 
+    p->running = false;
+    shutdown(p->listener_fd, SHUT_RDWR);
     if (pthread_join(tid, nullptr) != 0) {
         perror("pthread_join");
         return -1;
     }
-
+    stopWorkers(p);
+    int fd;
+    while (p->queue.pop(fd)) close(fd);
+    delete p;
     return 0;
 }
 
 
-// Internal reactor loop function (select)
+// Writes as much queued output as the socket takes without blocking. Call
+// with r->mutex held
+static void flushQueue(int fd, FdEntry& e) {
+    while (e.pending() > 0) {
+        ssize_t n = send(fd, e.out.data() + e.head, e.pending(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n <= 0) {
+            e.broken = true;
+            break;
+        }
+        e.head += n;
+    }
+    if (e.broken || e.pending() == 0) {
+        e.out.clear();
+        e.head = 0;
+    } else if (e.head > e.out.size() / 2) {
+        e.out.erase(0, e.head);
+        e.head = 0;
+    }
+}
+
+// Internal reactor loop function (poll: unlike select it has no fd limit,
+// and a reactor may hold thousands of write-only fds)
 void* reactorFunction(void* reactor_ptr) {
     Reactor* reactor = static_cast<Reactor*>(reactor_ptr);
+    std::vector<struct pollfd> pfds;
+    std::vector<reactorFunc> funcs;
     while (reactor->running) {
-        if (reactor->fds.empty()) {
-            usleep(1000);
-            continue;
-        }
-
-        fd_set readfds;
-        FD_ZERO(&readfds);
-        int max_fd = 0;
+        pfds.clear();
+        struct pollfd w;
+        w.fd = reactor->wake[0];
+        w.events = POLLIN;
+        pfds.push_back(w);
 
         pthread_mutex_lock(&reactor->mutex);
-        for (int fd : reactor->fds) {
-            FD_SET(fd, &readfds);
-            if (fd > max_fd) max_fd = fd;
+        for (auto& it : reactor->fds) {
+            short events = (it.second.func ? POLLIN : 0) | (it.second.pending() > 0 ? POLLOUT : 0);
+            if (events == 0) continue;
+            struct pollfd p;
+            p.fd = it.first;
+            p.events = events;
+            pfds.push_back(p);
         }
         pthread_mutex_unlock(&reactor->mutex);
 
-        struct timeval tv;
-        tv.tv_sec = 1;
-        tv.tv_usec = 0;
-
-        int result = select(max_fd + 1, &readfds, NULL, NULL, &tv);
+        int result = poll(pfds.data(), pfds.size(), 1000);
         if (result == -1) {
-            perror("select");
+            if (errno == EINTR) continue;
+            perror("poll");
             break;
         } else if (result == 0) {
             continue;
         }
-        
-        // Copy fds to avoid holding the mutex while processing
+
+        if (pfds[0].revents & POLLIN) {
+            char drain[64];
+            while (read(reactor->wake[0], drain, sizeof(drain)) > 0) {}
+        }
+
+        // Flush under the mutex, so a removed fd is never written again; call
+        // the read callbacks without it
+        funcs.assign(pfds.size(), nullptr);
         pthread_mutex_lock(&reactor->mutex);
-        std::vector<int> fds_copy = reactor->fds;
+        for (size_t i = 1; i < pfds.size(); i++) {
+            if (pfds[i].revents == 0) continue;
+            auto it = reactor->fds.find(pfds[i].fd);
+            if (it == reactor->fds.end()) continue;
+            if (pfds[i].revents & (POLLOUT | POLLERR | POLLHUP)) flushQueue(pfds[i].fd, it->second);
+            if (pfds[i].revents & (POLLIN | POLLERR | POLLHUP)) funcs[i] = it->second.func;
+        }
         pthread_mutex_unlock(&reactor->mutex);
-
-        for (int fd : fds_copy) {
-            if (FD_ISSET(fd, &readfds)) {
-                pthread_mutex_lock(&reactor->mutex);
-                auto it = reactor->reactorFuncs.find(fd);
-                reactorFunc func = (it != reactor->reactorFuncs.end()) ? it->second : nullptr;
-                pthread_mutex_unlock(&reactor->mutex);
-                if (func) func(fd);
-            }
+        for (size_t i = 1; i < pfds.size(); i++) {
+            if (funcs[i]) funcs[i](pfds[i].fd);
         }
     }
     return nullptr;
@@ -180,6 +399,12 @@ void* reactorFunction(void* reactor_ptr) {
 // Starts new reactor and returns pointer to it
 void* startReactor() {
     Reactor* reactor = new Reactor();
+    if (pipe(reactor->wake) != 0) {
+        delete reactor;
+        return nullptr;
+    }
+    fcntl(reactor->wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(reactor->wake[1], F_SETFL, O_NONBLOCK);
     reactor->running = true;
     if (pthread_create(&reactor->thread, nullptr, reactorFunction, reactor) != 0) {
         delete reactor;
@@ -188,36 +413,62 @@ void* startReactor() {
     return static_cast<void*>(reactor);
 }
 
-// Adds fd to Reactor (for reading); returns 0 on success
+// Adds fd to Reactor (for reading, or only for sendToReactor when func is
+// nullptr); returns 0 on success. A write-only fd may get a callback later
 int addFdToReactor(void* reactor, int fd, reactorFunc func) {
-    if (reactor == nullptr || func == nullptr) return -1;
+    if (reactor == nullptr) return -1;
     Reactor* r = static_cast<Reactor*>(reactor);
     pthread_mutex_lock(&r->mutex);
-    auto it = std::find(r->fds.begin(), r->fds.end(), fd);
-    if (it != r->fds.end()) {
+    auto it = r->fds.find(fd);
+    if (it != r->fds.end() && (it->second.func || !func)) {
         pthread_mutex_unlock(&r->mutex);
         return -1;
     }
-    r->fds.push_back(fd);
-    r->reactorFuncs[fd] = func;
+    r->fds[fd].func = func;
     pthread_mutex_unlock(&r->mutex);
+    // A read fd must join the next poll() at once
+    if (func) write(r->wake[1], "", 1);
     return 0;
 }
 
-// Removes fd from reactor
+// Removes fd from reactor, dropping any output still queued for it
 int removeFdFromReactor(void* reactor, int fd) {
     if (reactor == nullptr) return -1;
     Reactor* r = static_cast<Reactor*>(reactor);
     pthread_mutex_lock(&r->mutex);
-    auto it = std::find(r->fds.begin(), r->fds.end(), fd);
-    if (it == r->fds.end()) {
+    int result = r->fds.erase(fd) ? 0 : -1;
+    pthread_mutex_unlock(&r->mutex);
+    return result;
+}
+
+// Queues output for fd: writes what the socket takes now, the rest as it
+// becomes writable. Returns 0 on success
+int sendToReactor(void* reactor, int fd, const char* data, size_t len) {
+    if (reactor == nullptr) return -1;
+    Reactor* r = static_cast<Reactor*>(reactor);
+    pthread_mutex_lock(&r->mutex);
+    auto it = r->fds.find(fd);
+    if (it == r->fds.end() || it->second.broken) {
         pthread_mutex_unlock(&r->mutex);
         return -1;
     }
-    r->fds.erase(it);
-    r->reactorFuncs.erase(fd);
+    FdEntry& e = it->second;
+    bool idle = e.pending() == 0;
+    if (e.pending() + len > REACTOR_MAX_PENDING) {
+        // The peer stopped reading: give up on it rather than grow forever
+        e.broken = true;
+        e.out.clear();
+        e.head = 0;
+    } else {
+        e.out.append(data, len);
+        flushQueue(fd, e);
+    }
+    int result = e.broken ? -1 : 0;
+    bool queued = idle && e.pending() > 0;
     pthread_mutex_unlock(&r->mutex);
-    return 0;
+    // The loop only watches fds for writing that had output when it polled
+    if (queued) write(r->wake[1], "", 1);
+    return result;
 }
 
 // Stops reactor
@@ -225,10 +476,8 @@ int stopReactor(void* reactor) {
     if (reactor == nullptr) return -1;
     Reactor* r = static_cast<Reactor*>(reactor);
     r->running = false;
+    write(r->wake[1], "", 1);
     pthread_join(r->thread, nullptr);
     delete r;
     return 0;
 }
-
-
-#endif // REACTOR_HPP
\ No newline at end of file
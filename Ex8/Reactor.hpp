@@ -1,16 +1,29 @@
 #ifndef REACTOR_HPP
 #define REACTOR_HPP
 
+#include <cstddef>
+
 // Function pointer type for reactor callbacks
 typedef void *(*reactorFunc)(int fd);
 
 // Proactor function pointer type
 typedef void *(*proactorFunc)(int sock_fd);
 
+// Returned by a proactor handler that took the connection over (e.g. moved
+// it onto a reactor): the worker then leaves the fd open
+#define PROACTOR_FD_KEPT ((void *)1)
+
+// sets the size of the worker pool used by proactors started afterwards.
+// each worker serves one connection at a time (default 64); while all are
+// busy extra workers are started, up to 1024, and later connections are
+// refused with "Server busy"
+void setProactorWorkers(int n);
+
 // starts new proactor and returns proactor thread id.
 pthread_t startProactor(int sockfd, proactorFunc threadFunc);
 
-// stops proactor by threadid
+// stops proactor by threadid: shuts down the listener and the connections
+// being served, then waits for every handler to return
 int stopProactor(pthread_t tid);
 
 // Reactor structure declaration
@@ -19,12 +32,20 @@ struct Reactor;
 // Starts new reactor and returns pointer to it
 void *startReactor();
 
-// Adds fd to Reactor (for reading); returns 0 on success
+// Adds fd to Reactor (for reading, or only for sendToReactor when func is
+// nullptr); returns 0 on success. An fd added with nullptr may be added
+// again with a callback, keeping the output queued for it
 int addFdToReactor(void *reactor, int fd, reactorFunc func);
 
-// Removes fd from reactor
+// Removes fd from reactor, dropping any output still queued for it
 int removeFdFromReactor(void *reactor, int fd);
 
+// Queues len bytes for fd and writes what the socket accepts without
+// blocking; the rest is written by the loop when fd becomes writable, in
+// order. Returns -1 if fd is not registered, its peer is gone, or more than
+// 1 MiB would be left unwritten (the output is then dropped)
+int sendToReactor(void *reactor, int fd, const char *data, size_t len);
+
 // Stops reactor
 int stopReactor(void *reactor);
 
@@ -0,0 +1,283 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <atomic>
+#include <new>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "../common/MonotoneChain.hpp"
+#include "../common/HullEngines.hpp"
+#include "../common/HullFilter.hpp"
+#include "../common/ParallelHull.hpp"
+#include "../common/ChanHull.hpp"
+#include "../common/IncrementalHull.hpp"
+#include "../common/SimdKernels.hpp"
+
+using namespace std;
+
+// Benchmark of every hull engine in the repo over synthetic inputs.
+//
+//   hullbench [--csv | --json] [--min N] [--max N] [--iters K] [--warmup W]
+//             [--engines a,b,...] [--dists a,b,...] [--seed S]
+//
+// Sizes run over powers of ten from --min to --max (default 10 .. 10^6; up to
+// 10^8 needs about 5 GB). Each (engine, distribution, size) runs W warmup
+// and K timed iterations on a fresh copy of the same input. One row per
+// configuration reports the median and p99 (nearest rank) time, points per
+// second at the median, heap allocations per run and the hull area, which
+// must agree across engines.
+
+struct Point {
+    double x, y;
+
+    bool operator<(const Point &other) const {
+        return x < other.x || (x == other.x && y < other.y);
+    }
+};
+
+// Heap allocations, counted by the global operator new below and, through
+// simd_detail::aligned_allocations, by AlignedAllocator (which bypasses it)
+static atomic<size_t> allocations(0);
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// ---- Engines ----
+
+// Ex2's monotone chain on a deque, and the Graham scan the servers used
+vector<Point> dequeEngine(vector<Point>& pts) { return dequeHull(std::move(pts)); }
+
+vector<Point> grahamEngine(vector<Point>& pts) { return grahamScan(std::move(pts)); }
+
+vector<Point> vectorHull(vector<Point>& pts) { return hull_detail::monotoneChain(pts); }
+
+vector<Point> filteredHull(vector<Point>& pts) {
+    aklToussaintFilter(pts);
+    return hull_detail::monotoneChain(pts);
+}
+
+vector<Point> parallelEngine(vector<Point>& pts) { return parallelHull<Point>(pts); }
+
+vector<Point> chanEngine(vector<Point>& pts) { return chanHull(pts, estimateHullSize(pts)); }
+
+// Newpoint one at a time into the servers' incremental hull
+vector<Point> incrementalHull(vector<Point>& pts) {
+    IncrementalHull<Point> hull;
+    vector<Point> seen;
+    seen.reserve(pts.size());
+    for (const Point& p : pts) {
+        seen.push_back(p);
+        hull.insert(p);
+        hull.area(seen);
+    }
+    return hull.hull(seen);
+}
+
+struct Engine {
+    const char* name;
+    vector<Point> (*run)(vector<Point>&);
+    size_t max_size; // Larger inputs are skipped (quadratic or too slow)
+};
+
+const Engine engines[] = {
+    { "vector", vectorHull, 0 },
+    { "deque", dequeEngine, 0 },
+    { "graham", grahamEngine, 0 },
+    { "filtered", filteredHull, 0 },
+    { "parallel", parallelEngine, 0 },
+    { "chan", chanEngine, 0 },
+    { "incremental", incrementalHull, 10000 },
+};
+
+// ---- Distributions ----
+
+typedef void (*Generator)(vector<Point>&, size_t, mt19937_64&);
+
+void uniformSquare(vector<Point>& out, size_t n, mt19937_64& rng) {
+    uniform_real_distribution<double> u(-1000, 1000);
+    for (size_t i = 0; i < n; i++) out.push_back({ u(rng), u(rng) });
+}
+
+void uniformDisk(vector<Point>& out, size_t n, mt19937_64& rng) {
+    uniform_real_distribution<double> u(0, 1);
+    for (size_t i = 0; i < n; i++) {
+        double r = 1000 * sqrt(u(rng)), a = 2 * M_PI * u(rng);
+        out.push_back({ r * cos(a), r * sin(a) });
+    }
+}
+
+// Every point on the hull: the worst case for output-sensitive engines
+void circleBoundary(vector<Point>& out, size_t n, mt19937_64& rng) {
+    uniform_real_distribution<double> u(0, 2 * M_PI);
+    for (size_t i = 0; i < n; i++) {
+        double a = u(rng);
+        out.push_back({ 1000 * cos(a), 1000 * sin(a) });
+    }
+}
+
+// Gaussian blobs around 16 random centres
+void clustered(vector<Point>& out, size_t n, mt19937_64& rng) {
+    uniform_real_distribution<double> u(-1000, 1000);
+    normal_distribution<double> g(0, 20);
+    vector<Point> centres;
+    for (int i = 0; i < 16; i++) centres.push_back({ u(rng), u(rng) });
+    for (size_t i = 0; i < n; i++) {
+        const Point& c = centres[i % centres.size()];
+        out.push_back({ c.x + g(rng), c.y + g(rng) });
+    }
+}
+
+void collinear(vector<Point>& out, size_t n, mt19937_64& rng) {
+    uniform_real_distribution<double> u(-1000, 1000);
+    for (size_t i = 0; i < n; i++) {
+        double x = u(rng);
+        out.push_back({ x, 2 * x + 1 });
+    }
+}
+
+// Only 64 distinct points, each repeated
+void duplicates(vector<Point>& out, size_t n, mt19937_64& rng) {
+    uniform_real_distribution<double> u(-1000, 1000);
+    vector<Point> distinct;
+    for (int i = 0; i < 64; i++) distinct.push_back({ u(rng), u(rng) });
+    uniform_int_distribution<size_t> pick(0, distinct.size() - 1);
+    for (size_t i = 0; i < n; i++) out.push_back(distinct[pick(rng)]);
+}
+
+struct Distribution {
+    const char* name;
+    Generator generate;
+};
+
+const Distribution distributions[] = {
+    { "square", uniformSquare },
+    { "disk", uniformDisk },
+    { "circle", circleBoundary },
+    { "clustered", clustered },
+    { "collinear", collinear },
+    { "duplicates", duplicates },
+};
+
+// ---- Driver ----
+
+struct Options {
+    size_t min_size = 10, max_size = 1000000;
+    int iters = 21, warmup = 2;
+    unsigned long seed = 1;
+    bool json = false;
+    string engines, dists; // Comma lists; empty = all
+};
+
+bool selected(const string& list, const char* name) {
+    if (list.empty()) return true;
+    string padded = "," + list + ",";
+    return padded.find("," + string(name) + ",") != string::npos;
+}
+
+struct Result {
+    double median, p99, rate, allocs, area;
+    int runs;
+};
+
+Result measure(const Engine& e, const vector<Point>& input, const Options& opt) {
+    // Keep the largest sizes to a handful of runs
+    int iters = opt.iters;
+    if (input.size() >= 10000000) iters = min(iters, 3);
+    else if (input.size() >= 1000000) iters = min(iters, 7);
+
+    vector<double> times;
+    size_t allocs = 0;
+    double area = 0;
+    for (int i = 0; i < opt.warmup + iters; i++) {
+        vector<Point> pts(input);
+        size_t before = allocations.load(memory_order_relaxed);
+        auto start = chrono::steady_clock::now();
+        vector<Point> hull = e.run(pts);
+        auto end = chrono::steady_clock::now();
+        size_t made = allocations.load(memory_order_relaxed) - before;
+        if (i < opt.warmup) continue;
+        times.push_back(chrono::duration<double>(end - start).count());
+        allocs += made;
+        PointBuffer soa;
+        soa.assign(hull);
+        area = polygonAreaSoA(soa);
+    }
+    sort(times.begin(), times.end());
+    Result r;
+    r.runs = times.size();
+    r.median = times[times.size() / 2];
+    r.p99 = times[min(times.size() - 1, (size_t)ceil(0.99 * times.size()) - 1)];
+    r.rate = r.median > 0 ? input.size() / r.median : 0;
+    r.allocs = (double)allocs / times.size();
+    r.area = area;
+    return r;
+}
+
+int main(int argc, char* argv[]) {
+    simd_detail::aligned_allocations = &allocations;
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        bool has_value = i + 1 < argc;
+        if (a == "--csv") opt.json = false;
+        else if (a == "--json") opt.json = true;
+        else if (a == "--min" && has_value) opt.min_size = strtoull(argv[++i], nullptr, 10);
+        else if (a == "--max" && has_value) opt.max_size = strtoull(argv[++i], nullptr, 10);
+        else if (a == "--iters" && has_value) opt.iters = atoi(argv[++i]);
+        else if (a == "--warmup" && has_value) opt.warmup = atoi(argv[++i]);
+        else if (a == "--seed" && has_value) opt.seed = strtoul(argv[++i], nullptr, 10);
+        else if (a == "--engines" && has_value) opt.engines = argv[++i];
+        else if (a == "--dists" && has_value) opt.dists = argv[++i];
+        else {
+            cerr << "Usage: " << argv[0] << " [--csv | --json] [--min N] [--max N] [--iters K] [--warmup W]"
+                 << " [--engines a,b,...] [--dists a,b,...] [--seed S]" << endl;
+            return 1;
+        }
+    }
+    if (opt.iters < 1 || opt.warmup < 0 || opt.min_size < 1 || opt.max_size < opt.min_size) {
+        cerr << "Error: Invalid benchmark options." << endl;
+        return 1;
+    }
+
+    if (opt.json) printf("[\n");
+    else printf("engine,distribution,points,runs,median_s,p99_s,points_per_s,allocs_per_run,area\n");
+    bool first = true;
+    for (const Distribution& d : distributions) {
+        if (!selected(opt.dists, d.name)) continue;
+        for (size_t n = opt.min_size; n <= opt.max_size; n *= 10) {
+            mt19937_64 rng(opt.seed);
+            vector<Point> input;
+            input.reserve(n);
+            d.generate(input, n, rng);
+            for (const Engine& e : engines) {
+                if (!selected(opt.engines, e.name) || (e.max_size && n > e.max_size)) continue;
+                Result r = measure(e, input, opt);
+                if (opt.json) {
+                    printf("%s  {\"engine\": \"%s\", \"distribution\": \"%s\", \"points\": %zu, \"runs\": %d, "
+                           "\"median_s\": %.9g, \"p99_s\": %.9g, \"points_per_s\": %.6g, "
+                           "\"allocs_per_run\": %.6g, \"area\": %.17g}",
+                           first ? "" : ",\n", e.name, d.name, n, r.runs, r.median, r.p99, r.rate, r.allocs, r.area);
+                } else {
+                    printf("%s,%s,%zu,%d,%.9g,%.9g,%.6g,%.6g,%.17g\n",
+                           e.name, d.name, n, r.runs, r.median, r.p99, r.rate, r.allocs, r.area);
+                }
+                first = false;
+                fflush(stdout);
+            }
+            if (n > opt.max_size / 10) break; // n * 10 would pass the limit (or overflow)
+        }
+    }
+    if (opt.json) printf("%s]\n", first ? "" : "\n");
+    return 0;
+}
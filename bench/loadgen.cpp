@@ -0,0 +1,437 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <queue>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include "../common/LatencyHistogram.hpp"
+
+using namespace std;
+
+// Closed-loop load generator for the CH servers (Ex4, Ex6, Ex7, Ex9, Ex10).
+//
+//   loadgen [--host H] [--port P] [--conns N] [--threads T] [--rate R]
+//           [--duration S] [--mix newgraph=1,newpoint=50,removepoint=20,ch=29]
+//           [--graph-size N] [--per-line] [--seed S] [--json]
+//
+// Opens N connections spread over T threads (one epoll loop each). Every
+// connection has at most one command in flight: it sends a command picked
+// from the mix, waits for its whole reply, then sends the next. --rate caps
+// the total command rate (0 = as fast as the server answers); each
+// connection gets an equal share, and latency is measured from the time a
+// command was due rather than when it was sent, so a stalled server is not
+// hidden by the generator slowing down. Reports throughput and p50/p99/p999
+// per command as CSV, or JSON with --json.
+//
+// Newgraph sends its point lines in the same write and waits for the two
+// replies the servers give ("Ready ..." and "Graph created ..."). Ex4 answers
+// every point line of Newgraph, so for it use --per-line: each line is sent
+// on its own and answered before the next. For pipelined load see pipebench.
+
+#define PORT "9034"  // Port to connect to
+
+enum Command { NEWGRAPH, NEWPOINT, REMOVEPOINT, CH, COMMANDS };
+const char* command_names[COMMANDS] = { "newgraph", "newpoint", "removepoint", "ch" };
+
+struct Options {
+    string host = "localhost";
+    string port = PORT;
+    int conns = 100;
+    int threads = 0;
+    double rate = 0;
+    double duration = 10;
+    int weights[COMMANDS] = { 1, 50, 20, 29 };
+    int graph_size = 100;
+    bool per_line = false;
+    unsigned long seed = 1;
+    bool json = false;
+};
+
+typedef chrono::steady_clock Clock;
+
+// One request line (or a batch of lines) and how many reply lines end it
+struct Step {
+    string data;
+    int replies;
+};
+
+struct Connection {
+    int fd;
+    bool busy;
+    Command cmd;
+    vector<Step> steps;
+    size_t step;        // Current step
+    size_t sent;        // Bytes of the current step written
+    int replies_left;   // Reply lines still expected for the current step
+    Clock::time_point due; // When the current command was scheduled
+};
+
+struct WorkerStats {
+    LatencyHistogram latency[COMMANDS];
+    uint64_t errors;
+    WorkerStats() : errors(0) {}
+};
+
+// Connect to server (the client's connect_to_server, with a port)
+int connect_to_server(const char* hostname, const char* port) {
+    int sockfd = -1;
+    struct addrinfo hints, *servinfo, *p;
+    int rv;
+
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if ((rv = getaddrinfo(hostname, port, &hints, &servinfo)) != 0) {
+        fprintf(stderr, "getaddrinfo: %s\n", gai_strerror(rv));
+        return -1;
+    }
+
+    // Loop through all the results and connect to the first we can
+    for (p = servinfo; p != NULL; p = p->ai_next) {
+        if ((sockfd = socket(p->ai_family, p->ai_socktype, p->ai_protocol)) == -1) continue;
+        if (connect(sockfd, p->ai_addr, p->ai_addrlen) == -1) {
+            close(sockfd);
+            sockfd = -1;
+            continue;
+        }
+        break;
+    }
+    freeaddrinfo(servinfo);
+    if (sockfd == -1) return -1;
+
+    int one = 1;
+    setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL, 0) | O_NONBLOCK);
+    return sockfd;
+}
+
+class Worker {
+public:
+    Worker(const Options& opt, int nconns, unsigned long seed)
+        : opt_(opt), rng_(seed), coord_(-100, 100), nconns_(nconns), epfd_(-1) {
+        for (int w : opt.weights) total_weight_ += w;
+    }
+
+    ~Worker() {
+        for (Connection& c : conns_) {
+            if (c.fd >= 0) close(c.fd);
+        }
+        if (epfd_ >= 0) close(epfd_);
+    }
+
+    // Opens this worker's connections; false if one failed
+    bool connectAll() {
+        epfd_ = epoll_create1(0);
+        for (int i = 0; i < nconns_; i++) {
+            int fd = connect_to_server(opt_.host.c_str(), opt_.port.c_str());
+            if (fd < 0) {
+                fprintf(stderr, "loadgen: connection %d failed\n", i);
+                return false;
+            }
+            Connection c = Connection();
+            c.fd = fd;
+            conns_.push_back(c);
+            epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.u32 = i;
+            epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev);
+        }
+        return true;
+    }
+
+    // Drives the connections until end
+    void run(Clock::time_point end, WorkerStats& stats) {
+        end_ = end;
+
+        // Spread the first commands over one pacing interval
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < nconns_; i++) {
+            idle_.push(Due(start + chrono::duration_cast<Clock::duration>(interval() * i / nconns_), i));
+        }
+
+        vector<epoll_event> events(256);
+        char buf[65536];
+        // Past the end no new command starts; the ones in flight get up to a
+        // second to finish, so the servers are not cut off mid-reply
+        Clock::time_point drain_end = end_ + chrono::seconds(1);
+        for (;;) {
+            Clock::time_point now = Clock::now();
+            if (now >= end_ && (inFlight() == 0 || now >= drain_end)) break;
+            while (now < end_ && !idle_.empty() && idle_.top().first <= now) {
+                Due d = idle_.top();
+                idle_.pop();
+                begin(conns_[d.second], d.first, stats);
+            }
+            Clock::time_point wake = now < end_ ? end_ : drain_end;
+            if (now < end_ && !idle_.empty()) wake = min(wake, idle_.top().first);
+            int timeout = (int)chrono::duration_cast<chrono::milliseconds>(wake - Clock::now()).count();
+            int n = epoll_wait(epfd_, events.data(), events.size(), max(timeout, 0));
+            for (int k = 0; k < n; k++) {
+                Connection& c = conns_[events[k].data.u32];
+                if (c.fd < 0) continue;
+                if (events[k].events & EPOLLOUT) flush(c, stats);
+                if (events[k].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) receive(c, events[k].data.u32, buf, sizeof(buf), stats);
+            }
+        }
+    }
+
+private:
+    typedef pair<Clock::time_point, int> Due;
+
+    const Options& opt_;
+    mt19937_64 rng_;
+    uniform_int_distribution<int> coord_;
+    int total_weight_ = 0;
+    Clock::time_point end_;
+    int nconns_;
+    int epfd_;
+    vector<Connection> conns_;
+    priority_queue<Due, vector<Due>, greater<Due> > idle_; // Connections waiting for their next slot
+
+    int inFlight() const {
+        int n = 0;
+        for (const Connection& c : conns_) n += c.busy;
+        return n;
+    }
+
+    chrono::duration<double> interval() const {
+        return chrono::duration<double>(opt_.rate > 0 ? opt_.conns / opt_.rate : 0.0);
+    }
+
+    string randomPoint() {
+        return to_string(coord_(rng_)) + "," + to_string(coord_(rng_));
+    }
+
+    Command pick() {
+        int r = uniform_int_distribution<int>(0, total_weight_ - 1)(rng_);
+        for (int i = 0; i < COMMANDS; i++) {
+            if (r < opt_.weights[i]) return (Command)i;
+            r -= opt_.weights[i];
+        }
+        return CH;
+    }
+
+    // Builds the steps of the next command and starts writing it
+    void begin(Connection& c, Clock::time_point due, WorkerStats& stats) {
+        if (c.fd < 0) return;
+        c.cmd = pick();
+        c.steps.clear();
+        switch (c.cmd) {
+        case NEWGRAPH: {
+            string head = "Newgraph " + to_string(opt_.graph_size) + "\n";
+            if (opt_.per_line) {
+                c.steps.push_back({ head, 1 });
+                for (int i = 0; i < opt_.graph_size; i++) c.steps.push_back({ randomPoint() + "\n", 1 });
+            } else {
+                for (int i = 0; i < opt_.graph_size; i++) head += randomPoint() + "\n";
+                c.steps.push_back({ head, opt_.graph_size > 0 ? 2 : 1 });
+            }
+            break;
+        }
+        case NEWPOINT:
+            c.steps.push_back({ "Newpoint " + randomPoint() + "\n", 1 });
+            break;
+        case REMOVEPOINT:
+            c.steps.push_back({ "Removepoint " + randomPoint() + "\n", 1 });
+            break;
+        default:
+            c.steps.push_back({ "CH\n", 1 });
+            break;
+        }
+        c.busy = true;
+        c.due = due;
+        c.step = 0;
+        startStep(c, stats);
+    }
+
+    void startStep(Connection& c, WorkerStats& stats) {
+        c.sent = 0;
+        c.replies_left = c.steps[c.step].replies;
+        flush(c, stats);
+    }
+
+    // Writes what is left of the current step; waits for EPOLLOUT on a full socket
+    void flush(Connection& c, WorkerStats& stats) {
+        const string& data = c.steps[c.step].data;
+        while (c.sent < data.size()) {
+            ssize_t n = send(c.fd, data.data() + c.sent, data.size() - c.sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n <= 0) {
+                fail(c, stats);
+                return;
+            }
+            c.sent += n;
+        }
+        epoll_event ev;
+        ev.events = EPOLLIN | (c.sent < data.size() ? (uint32_t)EPOLLOUT : 0u);
+        ev.data.u32 = &c - conns_.data();
+        epoll_ctl(epfd_, EPOLL_CTL_MOD, c.fd, &ev);
+    }
+
+    // Counts reply lines; the last reply of the last step completes the command
+    void receive(Connection& c, int index, char* buf, size_t size, WorkerStats& stats) {
+        ssize_t n = recv(c.fd, buf, size, 0);
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) return;
+        if (n <= 0) {
+            fail(c, stats);
+            return;
+        }
+        const char* p = buf;
+        const char* e = buf + n;
+        while (c.busy && (p = (const char*)memchr(p, '\n', e - p)) != NULL) {
+            p++;
+            if (--c.replies_left > 0) continue;
+            if (++c.step < c.steps.size()) {
+                startStep(c, stats);
+                continue;
+            }
+            c.busy = false;
+            Clock::time_point now = Clock::now();
+            if (now >= end_) break;
+            stats.latency[c.cmd].record(chrono::duration_cast<chrono::nanoseconds>(now - c.due).count());
+            // Behind schedule the next command is due at once, but keeps its slot
+            Clock::time_point next = opt_.rate > 0 ? c.due + chrono::duration_cast<Clock::duration>(interval()) : now;
+            idle_.push(Due(next, index));
+        }
+    }
+
+    void fail(Connection& c, WorkerStats& stats) {
+        stats.errors++;
+        epoll_ctl(epfd_, EPOLL_CTL_DEL, c.fd, NULL);
+        close(c.fd);
+        c.fd = -1;
+        c.busy = false;
+    }
+};
+
+bool parseMix(const string& mix, int* weights) {
+    int parsed[COMMANDS] = { 0, 0, 0, 0 };
+    size_t start = 0;
+    while (start < mix.size()) {
+        size_t end = mix.find(',', start);
+        if (end == string::npos) end = mix.size();
+        string item = mix.substr(start, end - start);
+        size_t eq = item.find('=');
+        if (eq == string::npos) return false;
+        string name = item.substr(0, eq);
+        int i = 0;
+        while (i < COMMANDS && name != command_names[i]) i++;
+        if (i == COMMANDS) return false;
+        parsed[i] = atoi(item.c_str() + eq + 1);
+        if (parsed[i] < 0) return false;
+        start = end + 1;
+    }
+    int total = 0;
+    for (int i = 0; i < COMMANDS; i++) total += parsed[i];
+    if (total == 0) return false;
+    memcpy(weights, parsed, sizeof(parsed));
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        bool has_value = i + 1 < argc;
+        if (a == "--host" && has_value) opt.host = argv[++i];
+        else if (a == "--port" && has_value) opt.port = argv[++i];
+        else if (a == "--conns" && has_value) opt.conns = atoi(argv[++i]);
+        else if (a == "--threads" && has_value) opt.threads = atoi(argv[++i]);
+        else if (a == "--rate" && has_value) opt.rate = atof(argv[++i]);
+        else if (a == "--duration" && has_value) opt.duration = atof(argv[++i]);
+        else if (a == "--graph-size" && has_value) opt.graph_size = atoi(argv[++i]);
+        else if (a == "--seed" && has_value) opt.seed = strtoul(argv[++i], nullptr, 10);
+        else if (a == "--per-line") opt.per_line = true;
+        else if (a == "--json") opt.json = true;
+        else if (a == "--mix" && has_value) {
+            if (!parseMix(argv[++i], opt.weights)) {
+                cerr << "Error: Invalid command mix." << endl;
+                return 1;
+            }
+        } else {
+            cerr << "Usage: " << argv[0] << " [--host H] [--port P] [--conns N] [--threads T] [--rate R]"
+                 << " [--duration S] [--mix newgraph=1,newpoint=50,removepoint=20,ch=29]"
+                 << " [--graph-size N] [--per-line] [--seed S] [--json]" << endl;
+            return 1;
+        }
+    }
+    if (opt.threads <= 0) opt.threads = max(1u, thread::hardware_concurrency());
+    opt.threads = min(opt.threads, opt.conns);
+    if (opt.conns < 1 || opt.duration <= 0 || opt.rate < 0 || opt.graph_size < 0) {
+        cerr << "Error: Invalid load options." << endl;
+        return 1;
+    }
+
+    // Connect everything first, so slow accepts do not eat into the run
+    vector<Worker*> workers;
+    vector<char> ok(opt.threads, 0);
+    vector<thread> threads;
+    for (int t = 0; t < opt.threads; t++) {
+        int n = opt.conns * (t + 1) / opt.threads - opt.conns * t / opt.threads;
+        workers.push_back(new Worker(opt, n, opt.seed + t));
+    }
+    for (int t = 0; t < opt.threads; t++) {
+        threads.push_back(thread([&, t]() { ok[t] = workers[t]->connectAll(); }));
+    }
+    for (thread& t : threads) t.join();
+    threads.clear();
+    for (char k : ok) {
+        if (!k) return 1;
+    }
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(opt.duration));
+    vector<WorkerStats> stats(opt.threads);
+    for (int t = 0; t < opt.threads; t++) {
+        threads.push_back(thread([&, t]() { workers[t]->run(end, stats[t]); }));
+    }
+    for (thread& t : threads) t.join();
+    double elapsed = opt.duration; // Only commands finished before the end count
+    for (Worker* w : workers) delete w;
+
+    LatencyHistogram merged[COMMANDS], all;
+    uint64_t errors = 0;
+    for (const WorkerStats& s : stats) {
+        for (int i = 0; i < COMMANDS; i++) merged[i].merge(s.latency[i]);
+        errors += s.errors;
+    }
+    for (int i = 0; i < COMMANDS; i++) all.merge(merged[i]);
+
+    // Latencies in microseconds
+    if (opt.json) printf("{\"conns\": %d, \"threads\": %d, \"seconds\": %.3f, \"errors\": %llu, \"commands\": [\n",
+                         opt.conns, opt.threads, elapsed, (unsigned long long)errors);
+    else printf("command,count,per_s,mean_us,p50_us,p99_us,p999_us,max_us\n");
+    for (int i = 0; i <= COMMANDS; i++) {
+        const LatencyHistogram& h = i < COMMANDS ? merged[i] : all;
+        const char* name = i < COMMANDS ? command_names[i] : "all";
+        if (opt.json) {
+            printf("  {\"command\": \"%s\", \"count\": %llu, \"per_s\": %.1f, \"mean_us\": %.1f, \"p50_us\": %.1f, "
+                   "\"p99_us\": %.1f, \"p999_us\": %.1f, \"max_us\": %.1f}%s\n",
+                   name, (unsigned long long)h.count(), h.count() / elapsed, h.mean() / 1e3, h.percentile(0.5) / 1e3,
+                   h.percentile(0.99) / 1e3, h.percentile(0.999) / 1e3, h.max() / 1e3, i < COMMANDS ? "," : "");
+        } else {
+            printf("%s,%llu,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n", name, (unsigned long long)h.count(), h.count() / elapsed,
+                   h.mean() / 1e3, h.percentile(0.5) / 1e3, h.percentile(0.99) / 1e3, h.percentile(0.999) / 1e3,
+                   h.max() / 1e3);
+        }
+    }
+    if (opt.json) printf("]}\n");
+    if (errors > 0) fprintf(stderr, "loadgen: %llu connections failed\n", (unsigned long long)errors);
+    return 0;
+}
@@ -0,0 +1,297 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+
+using namespace std;
+
+// Pipelined throughput benchmark for the CH servers (Ex4, Ex6, Ex7, Ex9, Ex10).
+//
+//   pipebench [--host H] [--port P] [--conns N] [--depth 1,4,16,64,256]
+//             [--duration S] [--mix newpoint=50,removepoint=20,ch=30] [--json]
+//
+// For every depth D in the list, each of the N connections (one thread each)
+// writes D commands picked from the mix as a single batch, reads until all D
+// reply lines are back, then writes the next batch, for S seconds. Depth 1 is
+// the classic one-command-per-round-trip client; larger depths show how much
+// of the server's cost was per read and per write rather than per command.
+// Reports commands per second, the mean batch round trip and the speedup over
+// the first depth, as CSV or JSON with --json. Only commands with exactly one
+// reply line are used, so Newgraph is not part of the mix; instead every
+// depth starts from an empty graph ("Newgraph 0"), since the cost of
+// Removepoint grows with the graph and would skew the later depths.
+
+#define PORT "9034"  // Port to connect to
+
+enum Command { NEWPOINT, REMOVEPOINT, CH, COMMANDS };
+const char* command_names[COMMANDS] = { "newpoint", "removepoint", "ch" };
+
+// Batches prepared per connection and depth, replayed in turn
+#define BATCHES 8
+// A server that answers nothing for this long fails the run
+#define STALL_MS 5000
+
+struct Options {
+    string host = "localhost";
+    string port = PORT;
+    int conns = 4;
+    vector<int> depths = { 1, 4, 16, 64, 256 };
+    double duration = 3;
+    int weights[COMMANDS] = { 50, 20, 30 };
+    bool json = false;
+};
+
+typedef chrono::steady_clock Clock;
+
+struct Result {
+    uint64_t commands = 0;
+    uint64_t batches = 0;
+    double batch_ns = 0; // Sum of batch round trips
+    bool failed = false;
+};
+
+// Connect to server (the client's connect_to_server, with a port)
+int connect_to_server(const char* hostname, const char* port) {
+    int sockfd = -1;
+    struct addrinfo hints, *servinfo, *p;
+    int rv;
+
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if ((rv = getaddrinfo(hostname, port, &hints, &servinfo)) != 0) {
+        fprintf(stderr, "getaddrinfo: %s\n", gai_strerror(rv));
+        return -1;
+    }
+
+    // Loop through all the results and connect to the first we can
+    for (p = servinfo; p != NULL; p = p->ai_next) {
+        if ((sockfd = socket(p->ai_family, p->ai_socktype, p->ai_protocol)) == -1) continue;
+        if (connect(sockfd, p->ai_addr, p->ai_addrlen) == -1) {
+            close(sockfd);
+            sockfd = -1;
+            continue;
+        }
+        break;
+    }
+    freeaddrinfo(servinfo);
+    if (sockfd == -1) return -1;
+
+    int one = 1;
+    setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL, 0) | O_NONBLOCK);
+    return sockfd;
+}
+
+// depth commands from the mix, one per line
+string makeBatch(const Options& opt, int depth, mt19937_64& rng) {
+    int total = 0;
+    for (int w : opt.weights) total += w;
+    uniform_int_distribution<int> pick(0, total - 1), coord(-100, 100);
+    string batch;
+    for (int i = 0; i < depth; i++) {
+        int r = pick(rng), c = 0;
+        while (r >= opt.weights[c]) r -= opt.weights[c++];
+        if (c == CH) {
+            batch += "CH\n";
+            continue;
+        }
+        batch += c == NEWPOINT ? "Newpoint " : "Removepoint ";
+        batch += to_string(coord(rng)) + "," + to_string(coord(rng)) + "\n";
+    }
+    return batch;
+}
+
+// Sends one batch while reading its replies (a deep batch may not fit in the
+// socket buffers until the server's replies are drained); false on failure
+bool roundTrip(int fd, const string& batch, int depth) {
+    char buf[65536];
+    size_t sent = 0;
+    int replies = 0;
+    while (replies < depth) {
+        pollfd p;
+        p.fd = fd;
+        p.events = POLLIN | (sent < batch.size() ? POLLOUT : 0);
+        int n = poll(&p, 1, STALL_MS);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        if (p.revents & POLLOUT) {
+            ssize_t w = send(fd, batch.data() + sent, batch.size() - sent, MSG_NOSIGNAL);
+            if (w < 0 && errno != EAGAIN && errno != EINTR) return false;
+            if (w > 0) sent += w;
+        }
+        if (p.revents & (POLLIN | POLLERR | POLLHUP)) {
+            ssize_t r = recv(fd, buf, sizeof(buf), 0);
+            if (r == 0 || (r < 0 && errno != EAGAIN && errno != EINTR)) return false;
+            for (const char* q = buf; r > 0 && (q = (const char*)memchr(q, '\n', buf + r - q)); q++) replies++;
+        }
+    }
+    return true;
+}
+
+// Runs batches of depth commands on one connection until end
+void runConnection(const Options& opt, int fd, int depth, unsigned long seed, Clock::time_point end, Result& r) {
+    mt19937_64 rng(seed);
+    vector<string> batches;
+    for (int i = 0; i < BATCHES; i++) batches.push_back(makeBatch(opt, depth, rng));
+    for (size_t k = 0; Clock::now() < end; k++) {
+        Clock::time_point t0 = Clock::now();
+        if (!roundTrip(fd, batches[k % BATCHES], depth)) {
+            r.failed = true;
+            return;
+        }
+        r.batch_ns += chrono::duration_cast<chrono::nanoseconds>(Clock::now() - t0).count();
+        r.commands += depth;
+        r.batches++;
+    }
+}
+
+bool parseMix(const string& mix, int* weights) {
+    int parsed[COMMANDS] = { 0, 0, 0 };
+    size_t start = 0;
+    while (start < mix.size()) {
+        size_t end = mix.find(',', start);
+        if (end == string::npos) end = mix.size();
+        string item = mix.substr(start, end - start);
+        size_t eq = item.find('=');
+        if (eq == string::npos) return false;
+        string name = item.substr(0, eq);
+        int i = 0;
+        while (i < COMMANDS && name != command_names[i]) i++;
+        if (i == COMMANDS) return false;
+        parsed[i] = atoi(item.c_str() + eq + 1);
+        if (parsed[i] < 0) return false;
+        start = end + 1;
+    }
+    int total = 0;
+    for (int i = 0; i < COMMANDS; i++) total += parsed[i];
+    if (total == 0) return false;
+    memcpy(weights, parsed, sizeof(parsed));
+    return true;
+}
+
+bool parseDepths(const string& list, vector<int>& depths) {
+    vector<int> parsed;
+    size_t start = 0;
+    while (start < list.size()) {
+        size_t end = list.find(',', start);
+        if (end == string::npos) end = list.size();
+        int d = atoi(list.substr(start, end - start).c_str());
+        if (d < 1) return false;
+        parsed.push_back(d);
+        start = end + 1;
+    }
+    if (parsed.empty()) return false;
+    depths = parsed;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        bool has_value = i + 1 < argc;
+        if (a == "--host" && has_value) opt.host = argv[++i];
+        else if (a == "--port" && has_value) opt.port = argv[++i];
+        else if (a == "--conns" && has_value) opt.conns = atoi(argv[++i]);
+        else if (a == "--duration" && has_value) opt.duration = atof(argv[++i]);
+        else if (a == "--json") opt.json = true;
+        else if (a == "--depth" && has_value) {
+            if (!parseDepths(argv[++i], opt.depths)) {
+                cerr << "Error: Invalid depth list." << endl;
+                return 1;
+            }
+        } else if (a == "--mix" && has_value) {
+            if (!parseMix(argv[++i], opt.weights)) {
+                cerr << "Error: Invalid command mix." << endl;
+                return 1;
+            }
+        } else {
+            cerr << "Usage: " << argv[0] << " [--host H] [--port P] [--conns N] [--depth 1,4,16,64,256]"
+                 << " [--duration S] [--mix newpoint=50,removepoint=20,ch=30] [--json]" << endl;
+            return 1;
+        }
+    }
+    if (opt.conns < 1 || opt.duration <= 0) {
+        cerr << "Error: Invalid benchmark options." << endl;
+        return 1;
+    }
+
+    vector<int> fds;
+    for (int i = 0; i < opt.conns; i++) {
+        int fd = connect_to_server(opt.host.c_str(), opt.port.c_str());
+        if (fd < 0) {
+            fprintf(stderr, "pipebench: connection %d failed\n", i);
+            return 1;
+        }
+        fds.push_back(fd);
+    }
+
+    if (opt.json) printf("{\"conns\": %d, \"seconds\": %.3f, \"depths\": [\n", opt.conns, opt.duration);
+    else printf("depth,commands,seconds,per_s,batch_mean_us,speedup\n");
+    double base = 0;
+    int status = 0;
+    for (size_t d = 0; d < opt.depths.size(); d++) {
+        int depth = opt.depths[d];
+        if (!roundTrip(fds[0], "Newgraph 0\n", 1)) {
+            fprintf(stderr, "pipebench: could not reset the graph\n");
+            status = 1;
+            break;
+        }
+        vector<Result> results(opt.conns);
+        vector<thread> threads;
+        Clock::time_point start = Clock::now();
+        Clock::time_point end = start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(opt.duration));
+        for (int i = 0; i < opt.conns; i++) {
+            threads.push_back(thread(runConnection, cref(opt), fds[i], depth, 1000 * d + i + 1, end, ref(results[i])));
+        }
+        for (thread& t : threads) t.join();
+        // Batches in flight at the end finish after it, so time the whole run
+        double elapsed = chrono::duration<double>(Clock::now() - start).count();
+
+        Result all;
+        for (const Result& r : results) {
+            all.commands += r.commands;
+            all.batches += r.batches;
+            all.batch_ns += r.batch_ns;
+            all.failed |= r.failed;
+        }
+        if (all.failed) {
+            fprintf(stderr, "pipebench: a connection failed at depth %d\n", depth);
+            status = 1;
+            break;
+        }
+        double per_s = all.commands / elapsed;
+        double batch_us = all.batches ? all.batch_ns / all.batches / 1e3 : 0.0;
+        if (d == 0) base = per_s;
+        double speedup = base > 0 ? per_s / base : 0.0;
+        if (opt.json) {
+            printf("  {\"depth\": %d, \"commands\": %llu, \"seconds\": %.3f, \"per_s\": %.1f, \"batch_mean_us\": %.1f, "
+                   "\"speedup\": %.2f}%s\n", depth, (unsigned long long)all.commands, elapsed, per_s, batch_us, speedup,
+                   d + 1 < opt.depths.size() ? "," : "");
+        } else {
+            printf("%d,%llu,%.3f,%.1f,%.1f,%.2f\n", depth, (unsigned long long)all.commands, elapsed, per_s, batch_us,
+                   speedup);
+        }
+        fflush(stdout);
+    }
+    if (opt.json) printf("]}\n");
+    for (int fd : fds) close(fd);
+    return status;
+}
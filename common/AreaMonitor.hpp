@@ -0,0 +1,132 @@
+#ifndef AREA_MONITOR_HPP
+#define AREA_MONITOR_HPP
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <pthread.h>
+
+// Hull-area thresholds watched by a monitor thread.
+//
+// Whoever changes the graph (one writer at a time, e.g. under the graph's
+// mutex) hands an area it already has to publish(): a cached incremental
+// hull after a mutation, or the area a CH just computed. publish() stores it
+// in a versioned record and touches the monitor's mutex only when the
+// monitor is asleep. The monitor wakes, takes the newest record and checks
+// each threshold in O(1), so it never reads the graph, never computes a
+// hull and never makes a handler wait. Areas published while the monitor is
+// busy are coalesced: it always judges the latest one.
+class AreaMonitor {
+public:
+    // Called from the monitor thread for every crossing
+    typedef void (*Report)(double level, bool above, double area);
+    // Called from the monitor thread whenever the area it judges changes.
+    // A reset does not move from: whoever was told about the old graph's
+    // area learns about every threshold the new graph's area is past
+    typedef void (*Changed)(double from, double to);
+    AreaMonitor() : last_(0.0), reset_pending_(false), area_(0.0), resets_(0), version_(0), sleeping_(false) {
+        pthread_mutex_init(&mutex_, nullptr);
+        pthread_cond_init(&cond_, nullptr);
+    }
+    ~AreaMonitor() {
+        pthread_mutex_destroy(&mutex_);
+        pthread_cond_destroy(&cond_);
+    }
+
+    // The area reaching level crosses upward; it crosses back only once it
+    // falls below level - hysteresis. Add thresholds before run()
+    void addThreshold(double level, double hysteresis) {
+        Threshold t = { level, hysteresis, false };
+        thresholds_.push_back(t);
+        std::sort(thresholds_.begin(), thresholds_.end(),
+                  [](const Threshold& a, const Threshold& b) { return a.level < b.level; });
+    }
+
+    // Writer side: the graph's area as of its latest change. The version is
+    // odd while the record is being written
+    void publish(double area) {
+        version_.fetch_add(1);
+        if (reset_pending_) {
+            resets_.fetch_add(1);
+            reset_pending_ = false;
+        }
+        area_.store(area);
+        version_.fetch_add(1);
+        wake();
+    }
+
+    // Writer side: the graph was replaced, so every reported threshold starts
+    // below again without reporting a downward crossing (Changed still sees
+    // one). Sent with the next publish
+    void reset() { reset_pending_ = true; }
+
+    // Monitor side: reports crossings (and, if given, every change) forever
+    void run(Report report, Changed changed = nullptr) {
+        unsigned long seen = 0, seen_resets = 0;
+        while (true) {
+            pthread_mutex_lock(&mutex_);
+            sleeping_.store(true);
+            while (version_.load() == seen) pthread_cond_wait(&cond_, &mutex_);
+            sleeping_.store(false);
+            pthread_mutex_unlock(&mutex_);
+
+            // Seqlock read: area and resets must belong to the same version
+            unsigned long resets;
+            double area;
+            do {
+                seen = version_.load();
+                resets = resets_.load();
+                area = area_.load();
+            } while ((seen & 1) || version_.load() != seen);
+
+            judge(area, resets != seen_resets, report, changed);
+            seen_resets = resets;
+        }
+    }
+
+    // Monitor side: one step of run(), judging area (after a reset if reset)
+    void judge(double area, bool reset, Report report, Changed changed = nullptr) {
+        if (reset) {
+            for (Threshold& t : thresholds_) t.above = false;
+        }
+        for (Threshold& t : thresholds_) {
+            if (!t.above && area >= t.level) {
+                t.above = true;
+                report(t.level, true, area);
+            } else if (t.above && area < t.level - t.hysteresis) {
+                t.above = false;
+                report(t.level, false, area);
+            }
+        }
+        if (changed && area != last_) changed(last_, area);
+        last_ = area;
+    }
+
+private:
+    struct Threshold {
+        double level;
+        double hysteresis;
+        bool above; // Only touched by the monitor thread
+    };
+
+    // The monitor sets sleeping_ before its last version check and the writer
+    // bumps version_ before reading sleeping_, so one of them sees the other
+    void wake() {
+        if (!sleeping_.load()) return;
+        pthread_mutex_lock(&mutex_);
+        pthread_cond_signal(&cond_);
+        pthread_mutex_unlock(&mutex_);
+    }
+
+    std::vector<Threshold> thresholds_;
+    double last_; // Area of the last judge(), monitor only
+    bool reset_pending_; // Writer only
+    std::atomic<double> area_;
+    std::atomic<unsigned long> resets_;
+    std::atomic<unsigned long> version_;
+    std::atomic<bool> sleeping_;
+    pthread_mutex_t mutex_;
+    pthread_cond_t cond_;
+};
+
+#endif // AREA_MONITOR_HPP
@@ -0,0 +1,76 @@
+#ifndef BINARY_GRAPH_HPP
+#define BINARY_GRAPH_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include "PointFile.hpp"
+
+// Binary bulk load on the wire:
+//
+//   Newgraph-binary n\n  followed by n (x, y) pairs of little-endian float64
+//
+// The payload is 16 * n raw bytes with no separators, the same layout as the
+// body of an f64 point file (see PointFile.hpp). The server answers
+// "Graph created with n points" once all of them arrived.
+#define BINARY_GRAPH_COMMAND "Newgraph-binary"
+// 4M points: 64 MiB of coordinates plus a 32 MiB index at most
+#define BINARY_GRAPH_MAX_POINTS (1L << 22)
+#define BINARY_GRAPH_BLOCK 4096 // Points per recv block
+
+// Receives count points for Newgraph-binary into store (a PointStore). The
+// bytes already buffered in pending (a LineBuffer) are used first and
+// consumed, the rest is read from fd in blocks and appended without any text
+// conversion. Storage grows with the blocks that actually arrive, never with
+// the count the client announced. Blocks on fd, so call it without locks and
+// swap store into the graph afterwards. False if the connection closed or
+// failed before the last point
+template <typename Store, typename Input>
+bool recvBinaryGraph(int fd, Input& pending, size_t count, Store& store) {
+    std::vector<double> block(2 * std::min(count, (size_t)BINARY_GRAPH_BLOCK));
+    char* bytes = reinterpret_cast<char*>(block.data());
+    while (count > 0) {
+        size_t n = std::min(count, (size_t)BINARY_GRAPH_BLOCK);
+        size_t want = n * 2 * sizeof(double);
+        size_t have = std::min(want, (size_t)pending.unread().size());
+        memcpy(bytes, pending.unread().data(), have);
+        pending.consume(have);
+        while (have < want) {
+            ssize_t got = recv(fd, bytes + have, want - have, 0);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            have += got;
+        }
+        if (!pointfile_detail::littleEndian()) {
+            for (size_t i = 0; i < 2 * n; i++) block[i] = pointfile_detail::load<double>(bytes + 8 * i);
+        }
+        store.append(block.data(), n);
+        count -= n;
+    }
+    return true;
+}
+
+// Appends the whole points buffered in pending to store, at most count of
+// them, and consumes their bytes; returns how many it took. Never reads from
+// a socket, so an event loop can feed an upload as its bytes arrive
+template <typename Store, typename Input>
+size_t takeBinaryPoints(Input& pending, size_t count, Store& store) {
+    size_t n = std::min(count, pending.unread().size() / (2 * sizeof(double)));
+    if (n == 0) return 0;
+    std::vector<double> block(2 * n);
+    const char* bytes = pending.unread().data();
+    if (pointfile_detail::littleEndian()) {
+        memcpy(block.data(), bytes, n * 2 * sizeof(double));
+    } else {
+        for (size_t i = 0; i < 2 * n; i++) block[i] = pointfile_detail::load<double>(bytes + 8 * i);
+    }
+    pending.consume(n * 2 * sizeof(double));
+    store.append(block.data(), n);
+    return n;
+}
+
+#endif // BINARY_GRAPH_HPP
@@ -0,0 +1,210 @@
+#ifndef CHAN_HULL_HPP
+#define CHAN_HULL_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include "MonotoneChain.hpp"
+
+// Inputs smaller than this always use the plain monotone chain
+#define CHAN_MIN_POINTS 8192
+
+// Points sampled to estimate the hull size
+#define CHAN_SAMPLE_POINTS 1024
+
+// Automatic selection is on by default; HULL_CHAN=0 turns it off
+inline bool chanEnabled() {
+    static const bool enabled = !(getenv("HULL_CHAN") && strcmp(getenv("HULL_CHAN"), "0") == 0);
+    return enabled;
+}
+
+namespace chan_detail {
+
+using hull_detail::cross;
+using hull_detail::lessXY;
+using hull_detail::monotoneChain;
+
+inline int turn(double c) { return (c > 0) - (c < 0); }
+
+template <typename P>
+inline bool same(const P& a, const P& b) { return a.x == b.x && a.y == b.y; }
+
+template <typename P>
+inline double dist2(const P& a, const P& b) {
+    double dx = (double)a.x - b.x, dy = (double)a.y - b.y;
+    return dx * dx + dy * dy;
+}
+
+// True when no neighbour of h[c] lies right of p -> h[c]. For a convex hull
+// seen from outside, that local test is enough for a global tangent
+template <typename P>
+inline bool isTangent(const std::vector<P>& h, const P& p, size_t c) {
+    size_t m = h.size();
+    if (same(h[c], p)) return false;
+    return cross(p, h[c], h[(c + m - 1) % m]) >= 0 && cross(p, h[c], h[(c + 1) % m]) >= 0;
+}
+
+// Vertex q of the CCW hull h with every vertex left of (or on) p -> q.
+// Binary search in O(log m); anything it cannot settle (p on h, rounding)
+// falls back to a linear scan
+template <typename P>
+size_t tangent(const std::vector<P>& h, const P& p) {
+    size_t m = h.size();
+    if (m == 1) return 0;
+    size_t l = 0, r = m;
+    int l_prev = turn(cross(p, h[0], h[m - 1]));
+    int l_next = turn(cross(p, h[0], h[1 % m]));
+    size_t found = m;
+    while (l < r) {
+        size_t c = (l + r) / 2;
+        int c_prev = turn(cross(p, h[c], h[(c + m - 1) % m]));
+        int c_next = turn(cross(p, h[c], h[(c + 1) % m]));
+        int c_side = turn(cross(p, h[l], h[c]));
+        if (c_prev >= 0 && c_next >= 0) {
+            found = c;
+            break;
+        } else if ((c_side > 0 && (l_next < 0 || l_prev == l_next)) || (c_side < 0 && c_prev < 0)) {
+            r = c;
+        } else {
+            l = c + 1;
+            l_prev = -c_next;
+            l_next = turn(cross(p, h[l % m], h[(l + 1) % m]));
+        }
+    }
+    if (found == m) found = l % m;
+
+    if (!isTangent(h, p, found)) {
+        found = m;
+        for (size_t i = 0; i < m; i++) {
+            if (same(h[i], p)) continue;
+            if (found == m || cross(p, h[found], h[i]) < 0 ||
+                (cross(p, h[found], h[i]) == 0 && dist2(p, h[i]) > dist2(p, h[found]))) {
+                found = i;
+            }
+        }
+        return found == m ? 0 : found;
+    }
+    // Collinear neighbour further along the same ray is the better tangent
+    size_t next = (found + 1) % m;
+    if (cross(p, h[found], h[next]) == 0 && dist2(p, h[next]) > dist2(p, h[found])) found = next;
+    return found;
+}
+
+// One round of Chan: groups of size m, at most m wrapping steps.
+// Returns false when the hull has more than m vertices
+template <typename P>
+bool chanRound(const std::vector<P>& pts, size_t m, std::vector<P>& out) {
+    size_t n = pts.size();
+    std::vector<std::vector<P> > groups;
+    for (size_t b = 0; b < n; b += m) {
+        std::vector<P> chunk(pts.begin() + b, pts.begin() + std::min(n, b + m));
+        groups.push_back(monotoneChain(chunk));
+    }
+
+    // Start from the lowest point of the leftmost ones, always a hull vertex
+    size_t sg = 0, si = 0;
+    for (size_t g = 0; g < groups.size(); g++) {
+        for (size_t i = 0; i < groups[g].size(); i++) {
+            if (lessXY(groups[g][i], groups[sg][si])) {
+                sg = g;
+                si = i;
+            }
+        }
+    }
+
+    out.clear();
+    size_t cg = sg, ci = si;
+    for (size_t step = 0; step < m; step++) {
+        const P p = groups[cg][ci];
+        out.push_back(p);
+
+        // Own group: the next CCW vertex. Others: tangent by binary search
+        size_t bg = cg, bi = (ci + 1) % groups[cg].size();
+        for (size_t g = 0; g < groups.size(); g++) {
+            if (g == cg) continue;
+            size_t t = tangent(groups[g], p);
+            const P& q = groups[bg][bi];
+            const P& r = groups[g][t];
+            if (same(r, p)) continue;
+            double c = cross(p, q, r);
+            if (same(q, p) || c < 0 || (c == 0 && dist2(p, r) > dist2(p, q))) {
+                bg = g;
+                bi = t;
+            }
+        }
+        if (same(groups[bg][bi], p)) return true; // every point coincides with p
+        cg = bg;
+        ci = bi;
+        if (same(groups[cg][ci], groups[sg][si])) return true;
+    }
+    return false;
+}
+
+} // namespace chan_detail
+
+// Chan's output-sensitive convex hull, O(n log h). The hull is CCW, starting
+// at the lowest leftmost point. h_guess (e.g. from estimateHullSize) picks the
+// first group size; each failed round squares it
+template <typename P>
+std::vector<P> chanHull(const std::vector<P>& pts, size_t h_guess = 0) {
+    std::vector<P> out;
+    size_t n = pts.size();
+    if (n < 3) {
+        std::vector<P> copy(pts);
+        return hull_detail::monotoneChain(copy);
+    }
+    size_t m = 4;
+    while (m < 2 * h_guess && m < n) m *= 2;
+    for (;;) {
+        m = std::min(m, n);
+        if (chan_detail::chanRound(pts, m, out)) return out;
+        if (m == n) break;
+        m = m > n / m ? n : m * m;
+    }
+    std::vector<P> copy(pts);
+    return hull_detail::monotoneChain(copy);
+}
+
+// Estimated hull size: the hull of a strided sample, scaled by (n / sample)^(1/3).
+// Uniform points in a convex region have h ~ n^(1/3), the fastest growth seen
+// in practice, so this errs on the large side
+template <typename P>
+size_t estimateHullSize(const std::vector<P>& pts) {
+    size_t n = pts.size();
+    size_t stride = n > CHAN_SAMPLE_POINTS ? n / CHAN_SAMPLE_POINTS : 1;
+    std::vector<P> sample;
+    for (size_t i = 0; i < n; i += stride) sample.push_back(pts[i]);
+    size_t sampled = sample.size();
+    size_t h = hull_detail::monotoneChain(sample).size();
+    return (size_t)std::ceil(h * std::cbrt((double)n / sampled));
+}
+
+// Chan pays off when log h is well below log n
+inline bool chanPreferred(size_t n, size_t h_estimate) {
+    return n >= CHAN_MIN_POINTS && h_estimate * h_estimate * 64 <= n;
+}
+
+// Runs Chan's algorithm into out when the estimate says the hull is small;
+// false (and out untouched) otherwise
+template <typename P>
+bool tryChanHull(const std::vector<P>& pts, std::vector<P>& out) {
+    if (pts.size() < CHAN_MIN_POINTS || !chanEnabled()) return false;
+    size_t h = estimateHullSize(pts);
+    if (!chanPreferred(pts.size(), h)) return false;
+    out = chanHull(pts, h);
+    return true;
+}
+
+// Chan when the hull looks small, otherwise the monotone chain (which sorts
+// pts in place)
+template <typename P>
+std::vector<P> sequentialHull(std::vector<P>& pts) {
+    std::vector<P> out;
+    if (tryChanHull(pts, out)) return out;
+    return hull_detail::monotoneChain(pts);
+}
+
+#endif // CHAN_HULL_HPP
@@ -0,0 +1,61 @@
+#ifndef EPOCH_PTR_HPP
+#define EPOCH_PTR_HPP
+
+#include <atomic>
+#include <utility>
+#include <sched.h>
+
+// Pointer to an immutable object, read without locks and replaced atomically.
+//
+// Readers pin the current epoch in one of two counters, use the object, and
+// unpin. publish() swaps in the new object, then flips the epoch twice and
+// waits for each counter to drain before freeing the old one. Readers only
+// touch two atomics, so read throughput does not depend on writers.
+// Writers must be serialized by the caller (e.g. under graph_mutex).
+template <typename T>
+class EpochPtr {
+public:
+    explicit EpochPtr(T* initial) : current_(initial), epoch_(0) {
+        readers_[0].store(0);
+        readers_[1].store(0);
+    }
+    ~EpochPtr() { delete current_.load(); }
+
+    // Calls f with the current object and returns its result
+    template <typename F>
+    auto read(F f) const -> decltype(f(std::declval<const T&>())) {
+        unsigned e = epoch_.load();
+        std::atomic<long>& pin = readers_[e & 1];
+        pin.fetch_add(1);
+        struct Unpin {
+            std::atomic<long>& count;
+            ~Unpin() { count.fetch_sub(1); }
+        } unpin = { pin };
+        return f(*current_.load());
+    }
+
+    // Replaces the object; the old one is freed once no reader can hold it
+    void publish(T* next) {
+        T* old = current_.exchange(next);
+        synchronize();
+        delete old;
+    }
+
+private:
+    // Wait for every reader that might have loaded the old pointer
+    void synchronize() {
+        for (int round = 0; round < 2; round++) {
+            unsigned e = epoch_.fetch_add(1);
+            while (readers_[e & 1].load() != 0) sched_yield();
+        }
+    }
+
+    std::atomic<T*> current_;
+    std::atomic<unsigned> epoch_;
+    mutable std::atomic<long> readers_[2];
+
+    EpochPtr(const EpochPtr&);
+    EpochPtr& operator=(const EpochPtr&);
+};
+
+#endif // EPOCH_PTR_HPP
@@ -0,0 +1,230 @@
+#ifndef GRAPH_REGISTRY_HPP
+#define GRAPH_REGISTRY_HPP
+
+#include <map>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <functional>
+#include <utility>
+#include <pthread.h>
+#include "PointStore.hpp"
+#include "IncrementalHull.hpp"
+#include "EpochPtr.hpp"
+#include "LineBuffer.hpp"
+
+// Named graphs for the CH servers. Needs C++17.
+//
+// Every graph has its own mutex, points, hull cache and published snapshot,
+// so clients working on different graphs never wait for each other. A
+// connection starts on GRAPH_DEFAULT_NAME and switches with "Use <name>" or
+// "Newgraph <name> n"; graphs are created empty on first use and live for
+// the rest of the process, so a Graph* stays valid once obtained.
+
+#define GRAPH_DEFAULT_NAME "default"
+#define GRAPH_NAME_MAX 64
+// Graphs a server holds at most
+#define GRAPH_MAX_COUNT 1024
+// Memory all graphs may hold together. Graphs are never freed, so a Newgraph
+// that would pass it is refused (see GraphRegistry::admit)
+#define GRAPH_MAX_TOTAL_BYTES (1L << 30)
+// Bytes a point costs its graph: coordinates, index slots and hull share
+#define GRAPH_POINT_BYTES 32
+
+// One graph; Snapshot is the server's published view (default-constructible,
+// with an unsigned long version member).
+//
+// Snapshots are published lazily: a change only bumps version (changed()),
+// and the first read through current() that finds the snapshot older than
+// version publishes a new one. Repeated CH on an unchanged graph is then one
+// lock-free read, and a burst of changes costs one publish, not one each.
+template <typename P, typename Snapshot>
+struct NamedGraph {
+    std::string name;
+    pthread_mutex_t mutex;           // Serializes changes to this graph only
+    PointStore<P> points;
+    IncrementalHull<P> hull;         // Hull and area of points, updated per mutation
+    EpochPtr<Snapshot> snapshot;     // Last published view, read without the mutex
+    std::atomic<unsigned long> version; // Bumped by every completed change
+    std::atomic<size_t> size;        // Points, as of the last change
+    std::atomic<size_t> bytes;       // Memory held by points and hull, see account()
+    // Reads current() served from the snapshot / by publishing / by waiting
+    // for another reader's publish
+    std::atomic<unsigned long> hits, misses, shared;
+
+    // total: the registry's running sum of bytes, kept up to date by account()
+    NamedGraph(std::string_view n, double eps, std::atomic<size_t>* total)
+        : name(n), points(eps), snapshot(new Snapshot()), version(0), size(0), bytes(0), hits(0), misses(0),
+          shared(0), total_bytes(total), in_flight(false) {
+        pthread_mutex_init(&mutex, nullptr);
+        pthread_mutex_init(&flight_mutex, nullptr);
+        pthread_cond_init(&flight_done, nullptr);
+        account();
+    }
+    ~NamedGraph() {
+        pthread_mutex_destroy(&mutex);
+        pthread_mutex_destroy(&flight_mutex);
+        pthread_cond_destroy(&flight_done);
+    }
+
+    // Refreshes size and bytes; call with mutex held after a change
+    void account() {
+        size.store(points.size());
+        size_t now = points.memoryBytes() + hull.memoryBytes();
+        total_bytes->fetch_add(now - bytes.exchange(now)); // Wraps around when shrinking
+    }
+
+    // A change is complete and may be seen; call with mutex held. Changes in
+    // the middle of an upload are not complete, so readers keep the old view
+    void changed() {
+        version.store(version.load() + 1);
+        account();
+    }
+
+    // Whether a change came after the snapshot; call with mutex held
+    bool stale() const { return publishedVersion() != version.load(); }
+
+    // f applied to a snapshot that has every change completed before the
+    // call. When the current one is stale, publish(this) makes one under
+    // mutex. Single flight: the first stale reader publishes, and readers
+    // arriving meanwhile wait on flight_done and share its snapshot instead
+    // of queueing on mutex to find out there is nothing left to do
+    template <typename Publish, typename F>
+    auto current(Publish publish, F f) -> decltype(f(std::declval<const Snapshot&>())) {
+        unsigned long want = version.load();
+        bool fresh = false;
+        auto result = snapshot.read([&](const Snapshot& s) {
+            fresh = s.version >= want;
+            return f(s);
+        });
+        if (fresh) {
+            hits.fetch_add(1);
+            return result;
+        }
+
+        pthread_mutex_lock(&flight_mutex);
+        while (in_flight && publishedVersion() < want) pthread_cond_wait(&flight_done, &flight_mutex);
+        if (publishedVersion() >= want) {
+            pthread_mutex_unlock(&flight_mutex);
+            shared.fetch_add(1);
+            return snapshot.read(f);
+        }
+        in_flight = true;
+        pthread_mutex_unlock(&flight_mutex);
+
+        misses.fetch_add(1);
+        pthread_mutex_lock(&mutex);
+        if (stale()) publish(this);
+        pthread_mutex_unlock(&mutex);
+
+        pthread_mutex_lock(&flight_mutex);
+        in_flight = false;
+        pthread_cond_broadcast(&flight_done);
+        pthread_mutex_unlock(&flight_mutex);
+        return snapshot.read(f);
+    }
+
+private:
+    std::atomic<size_t>* total_bytes;
+    pthread_mutex_t flight_mutex; // Protects in_flight; never held with mutex
+    pthread_cond_t flight_done;   // Broadcast when a publish in flight ends
+    bool in_flight;               // A reader is publishing for current()
+
+    unsigned long publishedVersion() const {
+        return snapshot.read([](const Snapshot& s) { return s.version; });
+    }
+
+    NamedGraph(const NamedGraph&);
+    NamedGraph& operator=(const NamedGraph&);
+};
+
+// 1 to GRAPH_NAME_MAX characters of [A-Za-z0-9_.-]
+inline bool isGraphName(std::string_view name) {
+    if (name.empty() || name.size() > GRAPH_NAME_MAX) return false;
+    for (char c : name) {
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                  c == '_' || c == '.' || c == '-';
+        if (!ok) return false;
+    }
+    return true;
+}
+
+template <typename Graph>
+class GraphRegistry {
+public:
+    explicit GraphRegistry(double eps) : eps_(eps), bytes_(0) { pthread_mutex_init(&mutex_, nullptr); }
+    ~GraphRegistry() {
+        for (auto& it : graphs_) delete it.second;
+        pthread_mutex_destroy(&mutex_);
+    }
+
+    // The graph called name, created empty on first use; nullptr if the name
+    // is invalid or GRAPH_MAX_COUNT graphs already exist
+    Graph* get(std::string_view name) {
+        if (!isGraphName(name)) return nullptr;
+        pthread_mutex_lock(&mutex_);
+        Graph* g = nullptr;
+        auto it = graphs_.find(name);
+        if (it != graphs_.end()) {
+            g = it->second;
+        } else if (graphs_.size() < GRAPH_MAX_COUNT) {
+            g = new Graph(name, eps_, &bytes_);
+            graphs_.emplace(std::string(name), g);
+        }
+        pthread_mutex_unlock(&mutex_);
+        return g;
+    }
+
+    // Tolerance the graphs' points match within
+    double eps() const { return eps_; }
+
+    // Whether g may become a graph of n points without all graphs holding
+    // more than GRAPH_MAX_TOTAL_BYTES; g's current memory counts as freed.
+    // An estimate: uploads admitted at the same time don't see each other
+    bool admit(const Graph* g, size_t n) {
+        size_t total = bytes_.load();
+        size_t others = total - std::min(total, g->bytes.load());
+        if (others >= (size_t)GRAPH_MAX_TOTAL_BYTES) return n == 0;
+        return n <= (GRAPH_MAX_TOTAL_BYTES - others) / GRAPH_POINT_BYTES;
+    }
+
+    // Whether n more points fit, for Newpoint; O(1), like admit()
+    bool fits(size_t n) {
+        size_t total = bytes_.load();
+        if (total >= (size_t)GRAPH_MAX_TOTAL_BYTES) return false;
+        return n <= (GRAPH_MAX_TOTAL_BYTES - total) / GRAPH_POINT_BYTES;
+    }
+
+    // Number of graphs and the memory they hold in all
+    void totals(size_t& count, size_t& bytes) {
+        pthread_mutex_lock(&mutex_);
+        count = graphs_.size();
+        pthread_mutex_unlock(&mutex_);
+        bytes = bytes_.load();
+    }
+
+private:
+    double eps_;
+    std::atomic<size_t> bytes_; // Sum of every graph's bytes
+    pthread_mutex_t mutex_; // Protects graphs_ only, never held with a graph's mutex
+    std::map<std::string, Graph*, std::less<> > graphs_;
+
+    GraphRegistry(const GraphRegistry&);
+    GraphRegistry& operator=(const GraphRegistry&);
+};
+
+// Arguments of "Newgraph [<name>] n": with a name, g becomes that graph
+// (created if needed). False if n or the name is invalid; g is then unchanged
+template <typename Graph, typename T>
+bool parseNewgraphArgs(GraphRegistry<Graph>& graphs, std::string_view args, Graph*& g, T& n) {
+    std::string_view first = nextToken(args), second = nextToken(args);
+    if (second.empty()) return parseLeading(first, n);
+    if (!parseLeading(second, n)) return false;
+    Graph* named = graphs.get(first);
+    if (!named) return false;
+    g = named;
+    return true;
+}
+
+#endif // GRAPH_REGISTRY_HPP
@@ -0,0 +1,72 @@
+#ifndef HULL_ENGINES_HPP
+#define HULL_ENGINES_HPP
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include "MonotoneChain.hpp"
+
+// The two classic single-threaded engines the CH tools started from, shared
+// by the tools and the hull benchmark so both measure the same code. Both
+// return a strictly convex CCW hull and take their input by value (it is
+// sorted in place). P is any point type with x and y members.
+
+// Monotone chain built on a deque (Ex2's "Deque" engine)
+template <typename P>
+std::vector<P> dequeHull(std::vector<P> pts) {
+    int n = pts.size();
+    std::sort(pts.begin(), pts.end(), hull_detail::lessXY<P>);
+    std::deque<P> hull;
+
+    for (int i = 0; i < n; i++) {
+        while (hull.size() >= 2 && hull_detail::cross(hull[hull.size()-2], hull.back(), pts[i]) <= 0)
+            hull.pop_back();
+        hull.push_back(pts[i]);
+    }
+
+    size_t t = hull.size() + 1;
+    for (int i = n - 2; i >= 0; i--) {
+        while (hull.size() >= t && hull_detail::cross(hull[hull.size()-2], hull.back(), pts[i]) <= 0)
+            hull.pop_back();
+        hull.push_back(pts[i]);
+    }
+
+    if (!hull.empty()) hull.pop_back(); // The first point closes the chain again
+    return std::vector<P>(hull.begin(), hull.end());
+}
+
+// Graham scan around the lowest point (the servers' former engine). Points
+// are only kept on a strict left turn, so duplicates and points collinear
+// with an edge never reach the hull
+template <typename P>
+std::vector<P> grahamScan(std::vector<P> pts) {
+    if (pts.size() <= 1) return pts;
+    size_t min_idx = 0;
+    for (size_t i = 1; i < pts.size(); i++) {
+        if (pts[i].y < pts[min_idx].y || (pts[i].y == pts[min_idx].y && pts[i].x < pts[min_idx].x)) {
+            min_idx = i;
+        }
+    }
+    std::swap(pts[0], pts[min_idx]);
+    P pivot = pts[0];
+    std::sort(pts.begin() + 1, pts.end(), [&](const P& a, const P& b) {
+        double c = hull_detail::cross(pivot, a, b);
+        if (c == 0) {
+            double da = ((double)a.x - pivot.x) * ((double)a.x - pivot.x) + ((double)a.y - pivot.y) * ((double)a.y - pivot.y);
+            double db = ((double)b.x - pivot.x) * ((double)b.x - pivot.x) + ((double)b.y - pivot.y) * ((double)b.y - pivot.y);
+            return da < db;
+        }
+        return c > 0;
+    });
+
+    std::vector<P> hull;
+    for (const P& p : pts) {
+        while (hull.size() >= 2 && hull_detail::cross(hull[hull.size()-2], hull.back(), p) <= 0) hull.pop_back();
+        // Copies of the pivot sort first and would pass as a second vertex
+        if (hull.size() == 1 && p.x == pivot.x && p.y == pivot.y) continue;
+        hull.push_back(p);
+    }
+    return hull;
+}
+
+#endif // HULL_ENGINES_HPP
@@ -0,0 +1,86 @@
+#ifndef HULL_FILTER_HPP
+#define HULL_FILTER_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include "SimdKernels.hpp"
+
+// Inputs smaller than this are not worth filtering
+#define AKL_TOUSSAINT_MIN_POINTS 64
+
+// Block of points tested against the octagon at a time (fits in L1)
+#define AKL_TOUSSAINT_BLOCK 2048
+
+// The filter is on by default; HULL_FILTER=0 turns it off
+inline bool hullFilterEnabled() {
+    static const bool enabled = !(getenv("HULL_FILTER") && strcmp(getenv("HULL_FILTER"), "0") == 0);
+    return enabled;
+}
+
+// Akl-Toussaint interior-point culling.
+//
+// Finds the extreme points in x, y, x+y and x-y (min and max of each). In
+// counter-clockwise order they form a convex octagon whose vertices are
+// input points. Every point strictly inside that octagon cannot be on the
+// hull, so it is dropped before the O(n log n) sort. The inside test runs the
+// SIMD orientation kernel one octagon edge at a time over L1-sized blocks.
+// Surviving points keep their relative order. Returns how many were dropped.
+template <typename P>
+size_t aklToussaintFilter(std::vector<P>& pts) {
+    size_t n = pts.size();
+    if (n < AKL_TOUSSAINT_MIN_POINTS || !hullFilterEnabled()) return 0;
+
+    PointBuffer soa;
+    soa.assign(pts);
+    const double* x = soa.x.data();
+    const double* y = soa.y.data();
+
+    // min y, max x-y, max x, max x+y, max y, min x-y, min x, min x+y
+    size_t ext[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    for (size_t i = 1; i < n; i++) {
+        if (y[i] < y[ext[0]]) ext[0] = i;
+        if (x[i] - y[i] > x[ext[1]] - y[ext[1]]) ext[1] = i;
+        if (x[i] > x[ext[2]]) ext[2] = i;
+        if (x[i] + y[i] > x[ext[3]] + y[ext[3]]) ext[3] = i;
+        if (y[i] > y[ext[4]]) ext[4] = i;
+        if (x[i] - y[i] < x[ext[5]] - y[ext[5]]) ext[5] = i;
+        if (x[i] < x[ext[6]]) ext[6] = i;
+        if (x[i] + y[i] < x[ext[7]] + y[ext[7]]) ext[7] = i;
+    }
+
+    // Octagon vertices, dropping repeats when extremes coincide
+    double ox[8], oy[8];
+    int m = 0;
+    for (int k = 0; k < 8; k++) {
+        double px = x[ext[k]], py = y[ext[k]];
+        if (m > 0 && ox[m-1] == px && oy[m-1] == py) continue;
+        ox[m] = px;
+        oy[m] = py;
+        m++;
+    }
+    while (m > 1 && ox[m-1] == ox[0] && oy[m-1] == oy[0]) m--;
+    if (m < 3) return 0;
+
+    double orient[AKL_TOUSSAINT_BLOCK];
+    unsigned char inside[AKL_TOUSSAINT_BLOCK];
+    size_t kept = 0;
+    for (size_t b = 0; b < n; b += AKL_TOUSSAINT_BLOCK) {
+        size_t len = std::min((size_t)AKL_TOUSSAINT_BLOCK, n - b);
+        memset(inside, 1, len);
+        for (int e = 0; e < m; e++) {
+            int f = (e + 1) % m;
+            orientBatch(x + b, y + b, len, ox[e], oy[e], ox[f], oy[f], orient);
+            for (size_t i = 0; i < len; i++) inside[i] &= orient[i] > 0;
+        }
+        for (size_t i = 0; i < len; i++) {
+            if (!inside[i]) pts[kept++] = pts[b + i];
+        }
+    }
+    pts.resize(kept);
+    return n - kept;
+}
+
+#endif // HULL_FILTER_HPP
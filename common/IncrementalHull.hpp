@@ -0,0 +1,192 @@
+#ifndef INCREMENTAL_HULL_HPP
+#define INCREMENTAL_HULL_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "SimdKernels.hpp"
+#include "ParallelHull.hpp"
+
+// Convex hull kept up to date across Newpoint/Removepoint, with a cached area.
+//
+// The hull is stored counter-clockwise and strictly convex. Insertions are
+// applied in place: O(log h) when the point falls inside the hull (the usual
+// case), O(h) when it extends it. Removing a point strictly inside the hull
+// is O(log h) and changes nothing. Removing a hull vertex marks the cache
+// dirty, and the next area() call rebuilds it from the full point set
+// (in parallel from parallelCutoff() points up).
+// P is any point type with x and y members; the point set passed to area()
+// and hull() is any container with size() and operator[] returning P.
+// Rebuilds of at least this many points run in parallel; PARALLEL_HULL_CUTOFF
+// unless HULL_PARALLEL_CUTOFF=n overrides it
+inline size_t defaultParallelCutoff() {
+    static const char* env = getenv("HULL_PARALLEL_CUTOFF");
+    static const size_t cutoff = env ? strtoul(env, nullptr, 10) : PARALLEL_HULL_CUTOFF;
+    return cutoff;
+}
+
+template <typename P>
+class IncrementalHull {
+public:
+    IncrementalHull() : area_(0.0), valid_(true), hits_(0), misses_(0), cutoff_(defaultParallelCutoff()) {}
+
+    // Smallest point set a rebuild splits across cores
+    size_t parallelCutoff() const { return cutoff_; }
+    void setParallelCutoff(size_t n) { cutoff_ = n; }
+
+    // Graph was replaced by an empty one
+    void reset() {
+        hull_.clear();
+        soa_.clear();
+        area_ = 0.0;
+        valid_ = true;
+    }
+
+    // Forget the hull, the next area() call rebuilds it
+    void invalidate() { valid_ = false; }
+
+    // Point p was added to the graph
+    void insert(const P& p) {
+        if (!valid_) return;
+        if (hull_.size() < 3) {
+            // Degenerate hull, a rebuild is cheap enough and handles every case
+            valid_ = false;
+            return;
+        }
+        if (locate(p) >= 0) return;
+        extend(p);
+    }
+
+    // Point p (as stored in the graph) is about to be removed from it
+    void remove(const P& p) {
+        if (!valid_) return;
+        if (hull_.size() >= 3 && locate(p) > 0) return;
+        valid_ = false;
+    }
+
+    // Area of the hull of points, rebuilding only if the cache is dirty
+    template <typename C>
+    double area(const C& points) {
+        if (valid_) {
+            hits_++;
+        } else {
+            misses_++;
+            rebuild(points);
+        }
+        return area_;
+    }
+
+    // The cached area, without rebuilding; false while the cache is dirty
+    bool cachedArea(double& area) const {
+        if (valid_) area = area_;
+        return valid_;
+    }
+
+    // Current hull vertices (counter-clockwise), rebuilding if needed
+    template <typename C>
+    const std::vector<P>& hull(const C& points) {
+        if (!valid_) rebuild(points);
+        return hull_;
+    }
+
+    // area() calls answered from the cache / that had to rebuild it
+    unsigned long hits() const { return hits_; }
+    unsigned long misses() const { return misses_; }
+
+    // Bytes allocated for the cached hull
+    size_t memoryBytes() const {
+        return hull_.capacity() * sizeof(P) + (soa_.x.capacity() + soa_.y.capacity()) * sizeof(double);
+    }
+
+private:
+    std::vector<P> hull_;
+    PointBuffer soa_; // hull_ as SoA for the area kernel, kept in step with it
+    double area_;
+    bool valid_;
+    unsigned long hits_, misses_;
+    size_t cutoff_;
+
+    static double cross(const P& o, const P& a, const P& b) {
+        return ((double)a.x - o.x) * ((double)b.y - o.y) - ((double)a.y - o.y) * ((double)b.x - o.x);
+    }
+
+    // Full recompute, split across cores from cutoff_ points up
+    template <typename C>
+    void rebuild(const C& points) {
+        hull_ = parallelHull<P>(points, cutoff_);
+        soa_.assign(hull_);
+        area_ = polygonAreaSoA(soa_);
+        valid_ = true;
+    }
+
+    // 1 = strictly inside, 0 = on the boundary, -1 = outside. O(log h)
+    int locate(const P& p) const {
+        int m = hull_.size();
+        const P& o = hull_[0];
+        double c1 = cross(o, hull_[1], p);
+        double c2 = cross(o, hull_[m-1], p);
+        if (c1 < 0 || c2 > 0) return -1;
+
+        // Find the fan triangle (o, hull_[lo], hull_[lo+1]) containing p
+        int lo = 1, hi = m - 1;
+        while (hi - lo > 1) {
+            int mid = (lo + hi) / 2;
+            if (cross(o, hull_[mid], p) >= 0) lo = mid;
+            else hi = mid;
+        }
+        double c = cross(hull_[lo], hull_[lo+1], p);
+        if (c < 0) return -1;
+        if (c == 0) return 0;
+        if ((lo == 1 && c1 == 0) || (lo == m - 2 && c2 == 0)) return 0;
+        return 1;
+    }
+
+    // Add a point outside the hull: drop the vertices it can see, splice it in. O(h)
+    void extend(const P& p) {
+        int m = hull_.size();
+        std::vector<bool> visible(m);
+        for (int i = 0; i < m; i++) {
+            visible[i] = cross(hull_[i], hull_[(i+1) % m], p) <= 0;
+        }
+        // Visible edges form one contiguous run; find its first edge
+        int first = 0;
+        while (first < m && !(visible[first] && !visible[(first + m - 1) % m])) first++;
+        if (first == m) {
+            // Rounding left no clean visible run, fall back to a rebuild
+            valid_ = false;
+            return;
+        }
+        int last = first;
+        while (visible[(last + 1) % m]) last = (last + 1) % m;
+
+        // Vertices first+1 .. last (cyclically) are replaced by p, in hull_
+        // and in its SoA copy alike, so the area kernel needs no refill
+        size_t at = first + 1, count = (last - first + m) % m;
+        splice(hull_, at, count, p);
+        splice(soa_.x, at, count, (double)p.x);
+        splice(soa_.y, at, count, (double)p.y);
+        area_ = polygonAreaSoA(soa_);
+    }
+
+    // Replaces v[at .. at+count) (wrapping past the end) with value. The
+    // order stays cyclically the same; a wrapped run leaves value last
+    template <typename V, typename T>
+    static void splice(V& v, size_t at, size_t count, const T& value) {
+        size_t m = v.size();
+        if (at + count <= m) {
+            if (count == 0) {
+                v.insert(v.begin() + at, value);
+                return;
+            }
+            v[at] = value;
+            v.erase(v.begin() + at + 1, v.begin() + at + count);
+        } else {
+            v.erase(v.begin() + at, v.end());
+            v.erase(v.begin(), v.begin() + (at + count - m));
+            v.push_back(value);
+        }
+    }
+};
+
+#endif // INCREMENTAL_HULL_HPP
@@ -0,0 +1,72 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+// Log-linear latency histogram in the style of HdrHistogram.
+//
+// Values (nanoseconds) below 128 get one bucket each. Above that, each power
+// of two is split into 64 equal buckets, so every recorded value is known to
+// within 1/64 (about 1.6%) at any magnitude. Recording is O(1) with no
+// allocation; histograms from several threads are combined with merge().
+class LatencyHistogram {
+public:
+    LatencyHistogram() : counts_(BUCKETS, 0), total_(0), max_(0), sum_(0) {}
+
+    void record(uint64_t v) {
+        counts_[index(v)]++;
+        total_++;
+        sum_ += v;
+        max_ = std::max(max_, v);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BUCKETS; i++) counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        sum_ += other.sum_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    uint64_t count() const { return total_; }
+    uint64_t max() const { return max_; }
+    double mean() const { return total_ ? (double)sum_ / total_ : 0.0; }
+
+    // Value at quantile q (0..1): the highest value equivalent to the bucket
+    // holding the ceil(q * count)-th smallest sample, capped at the maximum
+    uint64_t percentile(double q) const {
+        if (total_ == 0) return 0;
+        uint64_t rank = (uint64_t)(q * total_ + 0.999999999);
+        if (rank < 1) rank = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            seen += counts_[i];
+            if (seen >= rank) return std::min(highest(i), max_);
+        }
+        return max_;
+    }
+
+private:
+    static const size_t BUCKETS = 64 * 58 + 128;
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_, max_, sum_;
+
+    // shift = number of low bits dropped; the kept top 7 bits pick the sub-bucket
+    static size_t index(uint64_t v) {
+        if (v < 128) return v;
+        int shift = 63 - __builtin_clzll(v) - 6;
+        return 64 * shift + (v >> shift);
+    }
+
+    static uint64_t highest(size_t i) {
+        if (i < 128) return i;
+        int shift = i / 64 - 1;
+        uint64_t sub = i - 64 * shift;
+        return ((sub + 1) << shift) - 1;
+    }
+};
+
+#endif // LATENCY_HISTOGRAM_HPP
@@ -0,0 +1,101 @@
+#ifndef LINE_BUFFER_HPP
+#define LINE_BUFFER_HPP
+
+#include <vector>
+#include <string_view>
+#include <charconv>
+#include <cstring>
+#include <cstddef>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+// Bytes of input a connection may have buffered: the longest accepted line
+#define LINE_BUFFER_CAPACITY (16 << 10)
+
+// Fixed-capacity input buffer for one connection. Needs C++17.
+//
+// recv() writes straight into the free tail of the buffer and complete lines
+// are found with memchr and handed out as string_views into it, so framing a
+// command costs no allocation and no copy. Consumed bytes are reclaimed by
+// moving the unread rest to the front once per fill, never once per line.
+class LineBuffer {
+public:
+    explicit LineBuffer(size_t capacity = LINE_BUFFER_CAPACITY) : buf_(capacity), begin_(0), end_(0) {}
+
+    // One recv() into the free space; returns its result. A buffer that is
+    // full without a complete line returns -1 with errno = EMSGSIZE
+    ssize_t fill(int fd) {
+        if (begin_ > 0) {
+            memmove(buf_.data(), buf_.data() + begin_, end_ - begin_);
+            end_ -= begin_;
+            begin_ = 0;
+        }
+        if (end_ == buf_.size()) {
+            errno = EMSGSIZE;
+            return -1;
+        }
+        ssize_t n = recv(fd, buf_.data() + end_, buf_.size() - end_, 0);
+        if (n > 0) end_ += n;
+        return n;
+    }
+
+    // Next complete line without its "\n" (or "\r\n"); false if there is none
+    bool nextLine(std::string_view& line) {
+        const char* start = buf_.data() + begin_;
+        const char* nl = static_cast<const char*>(memchr(start, '\n', end_ - begin_));
+        if (!nl) return false;
+        size_t len = nl - start;
+        begin_ += len + 1;
+        if (len > 0 && start[len - 1] == '\r') len--;
+        line = std::string_view(start, len);
+        return true;
+    }
+
+    // Unread bytes (for binary payloads), and dropping n of them
+    std::string_view unread() const { return std::string_view(buf_.data() + begin_, end_ - begin_); }
+    void consume(size_t n) { begin_ += n; }
+
+private:
+    std::vector<char> buf_;
+    size_t begin_, end_; // Unread bytes are [begin_, end_)
+};
+
+// Command tokens as views, with the stream-extraction rules the servers
+// used: blanks separate tokens, numbers may have a leading '+' and trailing
+// junk after a number is ignored (like std::stod).
+
+inline bool isCommandBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+// Next blank-separated token of rest (empty at the end); rest moves past it
+inline std::string_view nextToken(std::string_view& rest) {
+    size_t i = 0;
+    while (i < rest.size() && isCommandBlank(rest[i])) i++;
+    size_t j = i;
+    while (j < rest.size() && !isCommandBlank(rest[j])) j++;
+    std::string_view token = rest.substr(i, j - i);
+    rest.remove_prefix(j);
+    return token;
+}
+
+// Leading number of s after blanks; false if there is none
+template <typename T>
+inline bool parseLeading(std::string_view s, T& v) {
+    size_t i = 0;
+    while (i < s.size() && isCommandBlank(s[i])) i++;
+    if (i < s.size() && s[i] == '+') i++;
+    std::from_chars_result r = std::from_chars(s.data() + i, s.data() + s.size(), v);
+    return r.ec == std::errc() && r.ptr != s.data() + i;
+}
+
+// "x,y" as two numbers; false without a comma or when either side is not one
+template <typename T>
+inline bool parseCoords(std::string_view s, T& x, T& y) {
+    size_t comma = s.find(',');
+    if (comma == std::string_view::npos) return false;
+    return parseLeading(s.substr(0, comma), x) && parseLeading(s.substr(comma + 1), y);
+}
+
+#endif // LINE_BUFFER_HPP
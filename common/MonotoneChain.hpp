@@ -0,0 +1,40 @@
+#ifndef MONOTONE_CHAIN_HPP
+#define MONOTONE_CHAIN_HPP
+
+#include <vector>
+#include <algorithm>
+
+namespace hull_detail {
+
+template <typename P>
+inline double cross(const P& o, const P& a, const P& b) {
+    return ((double)a.x - o.x) * ((double)b.y - o.y) - ((double)a.y - o.y) * ((double)b.x - o.x);
+}
+
+template <typename P>
+inline bool lessXY(const P& a, const P& b) {
+    return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+// Monotone chain; sorts pts in place and returns a strictly convex CCW hull
+template <typename P>
+std::vector<P> monotoneChain(std::vector<P>& pts) {
+    std::sort(pts.begin(), pts.end(), lessXY<P>);
+    int n = pts.size(), k = 0;
+    if (n < 3) return pts;
+    std::vector<P> hull(2 * n);
+    for (int i = 0; i < n; ++i) {
+        while (k >= 2 && cross(hull[k-2], hull[k-1], pts[i]) <= 0) k--;
+        hull[k++] = pts[i];
+    }
+    for (int i = n - 2, t = k + 1; i >= 0; --i) {
+        while (k >= t && cross(hull[k-2], hull[k-1], pts[i]) <= 0) k--;
+        hull[k++] = pts[i];
+    }
+    hull.resize(k - 1);
+    return hull;
+}
+
+} // namespace hull_detail
+
+#endif // MONOTONE_CHAIN_HPP
@@ -0,0 +1,67 @@
+#ifndef PARALLEL_HULL_HPP
+#define PARALLEL_HULL_HPP
+
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <cstddef>
+#include "HullFilter.hpp"
+#include "MonotoneChain.hpp"
+#include "ChanHull.hpp"
+
+// Below this many points parallelHull runs sequentially (monotone chain, or
+// Chan's algorithm when the hull looks small)
+#define PARALLEL_HULL_CUTOFF 200000
+
+// Convex hull (strictly convex, CCW) of any indexable container of points.
+//
+// Below cutoff points the hull is computed sequentially. Otherwise the points
+// are split into one chunk per thread. Each thread copies its chunk, drops the
+// points inside the chunk's own Akl-Toussaint octagon (they cannot be on the
+// chunk's hull, so not on the whole one either), then sorts and hulls what is
+// left. A final monotone chain runs over the union of the sub-hulls. The hull
+// of a union equals the hull of its parts' hulls, and the sub-hulls are tiny,
+// so the merge is cheap. The points dropped by the filter go to *discarded
+// when given. threads = 0 uses every core.
+template <typename P, typename C>
+std::vector<P> parallelHull(const C& points, size_t cutoff = PARALLEL_HULL_CUTOFF, unsigned threads = 0,
+                            size_t* discarded = nullptr) {
+    size_t n = points.size();
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (n / threads < 1024) threads = 1;
+    if (n < cutoff || threads == 1) {
+        std::vector<P> pts;
+        pts.reserve(n);
+        for (size_t i = 0; i < n; i++) pts.push_back(points[i]);
+        size_t dropped = aklToussaintFilter(pts);
+        if (discarded) *discarded = dropped;
+        return sequentialHull(pts);
+    }
+
+    std::vector<std::vector<P> > sub(threads);
+    std::vector<size_t> dropped(threads);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        size_t begin = n * t / threads, end = n * (t + 1) / threads;
+        workers.push_back(std::thread([&points, &sub, &dropped, t, begin, end]() {
+            std::vector<P> chunk;
+            chunk.reserve(end - begin);
+            for (size_t i = begin; i < end; i++) chunk.push_back(points[i]);
+            dropped[t] = aklToussaintFilter(chunk);
+            sub[t] = hull_detail::monotoneChain(chunk);
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+
+    std::vector<P> merged;
+    size_t total = 0;
+    for (size_t t = 0; t < sub.size(); t++) {
+        merged.insert(merged.end(), sub[t].begin(), sub[t].end());
+        total += dropped[t];
+    }
+    if (discarded) *discarded = total;
+    return hull_detail::monotoneChain(merged);
+}
+
+#endif // PARALLEL_HULL_HPP
@@ -0,0 +1,152 @@
+#ifndef POINT_FILE_HPP
+#define POINT_FILE_HPP
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+// Binary point file, version 1. All fields little-endian:
+//
+//   offset  size  field
+//        0     4  magic "CHPT"
+//        4     2  version (1)
+//        6     2  precision: 4 = float32, 8 = float64
+//        8     8  point count
+//       16    32  bounding box: min x, min y, max x, max y (float64)
+//       48        count (x, y) pairs at the given precision
+//
+// Loading is a straight copy of the coordinates, with no text conversion.
+#define POINT_FILE_MAGIC "CHPT"
+#define POINT_FILE_VERSION 1
+#define POINT_FILE_HEADER 48
+
+struct PointFileHeader {
+    uint16_t version;
+    uint16_t precision;
+    uint64_t count;
+    double min_x, min_y, max_x, max_y;
+};
+
+namespace pointfile_detail {
+
+inline bool littleEndian() {
+    const uint16_t one = 1;
+    unsigned char b;
+    memcpy(&b, &one, 1);
+    return b == 1;
+}
+
+// Unaligned little-endian load/store of a 2, 4 or 8 byte value
+template <typename T>
+inline T load(const char* p) {
+    unsigned char b[sizeof(T)];
+    memcpy(b, p, sizeof(T));
+    if (!littleEndian()) {
+        for (size_t i = 0; i < sizeof(T) / 2; i++) std::swap(b[i], b[sizeof(T) - 1 - i]);
+    }
+    T v;
+    memcpy(&v, b, sizeof(T));
+    return v;
+}
+
+template <typename T>
+inline void store(char* p, T v) {
+    memcpy(p, &v, sizeof(T));
+    if (!littleEndian()) {
+        for (size_t i = 0; i < sizeof(T) / 2; i++) std::swap(p[i], p[sizeof(T) - 1 - i]);
+    }
+}
+
+template <typename T, typename P>
+void decode(const char* body, size_t count, P* out) {
+    if (littleEndian() && sizeof(P) == 2 * sizeof(T) && sizeof(out->x) == sizeof(T)) {
+        // Same layout as the file: one copy
+        memcpy(static_cast<void*>(out), body, count * 2 * sizeof(T));
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        out[i].x = load<T>(body + (2 * i) * sizeof(T));
+        out[i].y = load<T>(body + (2 * i + 1) * sizeof(T));
+    }
+}
+
+} // namespace pointfile_detail
+
+// True when the data starts with the binary point file magic
+inline bool isPointFile(const char* data, size_t size) {
+    return size >= 4 && memcmp(data, POINT_FILE_MAGIC, 4) == 0;
+}
+
+// Parses and checks the header: magic, version and precision
+inline bool readPointFileHeader(const char* data, size_t size, PointFileHeader& h) {
+    using pointfile_detail::load;
+    if (size < POINT_FILE_HEADER || !isPointFile(data, size)) return false;
+    h.version = load<uint16_t>(data + 4);
+    h.precision = load<uint16_t>(data + 6);
+    h.count = load<uint64_t>(data + 8);
+    h.min_x = load<double>(data + 16);
+    h.min_y = load<double>(data + 24);
+    h.max_x = load<double>(data + 32);
+    h.max_y = load<double>(data + 40);
+    return h.version == POINT_FILE_VERSION && (h.precision == 4 || h.precision == 8);
+}
+
+// How many points a file of size bytes with header h actually holds
+inline uint64_t pointFileCapacity(const PointFileHeader& h, size_t size) {
+    return (size - POINT_FILE_HEADER) / (2 * h.precision);
+}
+
+// Copies the header's count points into out; the file must hold them all
+template <typename P>
+void decodePointFile(const char* data, const PointFileHeader& h, P* out) {
+    if (h.precision == 4) pointfile_detail::decode<float>(data + POINT_FILE_HEADER, h.count, out);
+    else pointfile_detail::decode<double>(data + POINT_FILE_HEADER, h.count, out);
+}
+
+// Writes points (any container of points with x and y) to f at precision 4
+// or 8. False on a write error
+template <typename C>
+bool writePointFile(FILE* f, const C& points, unsigned precision) {
+    using pointfile_detail::store;
+    size_t n = points.size();
+    char header[POINT_FILE_HEADER];
+    memset(header, 0, sizeof(header));
+    memcpy(header, POINT_FILE_MAGIC, 4);
+    double box[4] = { 0, 0, 0, 0 };
+    for (size_t i = 0; i < n; i++) {
+        double x = points[i].x, y = points[i].y;
+        if (i == 0 || x < box[0]) box[0] = x;
+        if (i == 0 || y < box[1]) box[1] = y;
+        if (i == 0 || x > box[2]) box[2] = x;
+        if (i == 0 || y > box[3]) box[3] = y;
+    }
+    store<uint16_t>(header + 4, POINT_FILE_VERSION);
+    store<uint16_t>(header + 6, precision);
+    store<uint64_t>(header + 8, n);
+    for (int k = 0; k < 4; k++) store<double>(header + 16 + 8 * k, box[k]);
+    if (fwrite(header, 1, sizeof(header), f) != sizeof(header)) return false;
+
+    std::vector<char> block(1 << 16);
+    size_t per = block.size() / (2 * precision);
+    for (size_t b = 0; b < n; b += per) {
+        size_t len = std::min(per, n - b);
+        for (size_t i = 0; i < len; i++) {
+            char* p = block.data() + 2 * i * precision;
+            if (precision == 4) {
+                store<float>(p, (float)points[b + i].x);
+                store<float>(p + 4, (float)points[b + i].y);
+            } else {
+                store<double>(p, (double)points[b + i].x);
+                store<double>(p + 8, (double)points[b + i].y);
+            }
+        }
+        if (fwrite(block.data(), 2 * precision, len, f) != len) return false;
+    }
+    return true;
+}
+
+#endif // POINT_FILE_HPP
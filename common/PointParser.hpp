@@ -0,0 +1,324 @@
+#ifndef POINT_PARSER_HPP
+#define POINT_PARSER_HPP
+
+#include <vector>
+#include <charconv>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "PointFile.hpp"
+
+// Line parser for the CH tools' input format: a point count, then one
+// "x,y" (or "x y") line per point. Needs C++17 for std::from_chars.
+//
+// Input is read from fd in large blocks into one buffer and numbers are
+// parsed in place, so a point costs no allocation. Commas count as blanks,
+// the same as the getline + replace + stringstream reader it replaces.
+class PointParser {
+public:
+    // COUNT: bad point count. OPEN: the input file could not be mapped
+    enum Status { OK, END, INVALID, EXTRA, COUNT, OPEN };
+
+    explicit PointParser(int fd = 0, size_t block = 1 << 20)
+        : fd_(fd), block_(block), buf_(block), begin_(0), end_(0), eof_(false) {}
+
+    // The leading point count. Like cin >> n followed by cin.ignore(), it
+    // skips blanks, reads an integer and consumes exactly one more character
+    bool readCount(int& n) {
+        for (;;) {
+            while (begin_ < end_ && isBlank(buf_[begin_])) begin_++;
+            if (begin_ == end_) {
+                if (!fill()) return false;
+                continue;
+            }
+            // A number cut by the block end: pull in the rest before parsing
+            size_t k = begin_;
+            while (k < end_ && !isBlank(buf_[k])) k++;
+            if (k == end_ && fill()) continue;
+            break;
+        }
+        const char* p = buf_.data() + begin_;
+        if (!parseCount(p, buf_.data() + end_, n)) return false;
+        begin_ = p - buf_.data();
+        if (begin_ < end_ || fill()) begin_++;
+        return true;
+    }
+
+    // Parses the next line into p.x and p.y. END when the input ran out,
+    // INVALID when two numbers could not be read, EXTRA when more follows
+    template <typename P>
+    Status readPoint(P& p) {
+        const char* line;
+        const char* stop;
+        if (!nextLine(line, stop)) return END;
+        return parseLine(line, stop, p);
+    }
+
+    // Integer at s (after blanks); s is left just past it
+    static bool parseCount(const char*& s, const char* e, int& n) {
+        return parseNumber(s, e, n);
+    }
+
+    // One point line [s, e) without its newline
+    template <typename P>
+    static Status parseLine(const char* s, const char* e, P& p) {
+        if (!parseNumber(s, e, p.x) || !parseNumber(s, e, p.y)) return INVALID;
+        skipBlanks(s, e);
+        return s < e ? EXTRA : OK;
+    }
+
+private:
+    int fd_;
+    size_t block_;
+    std::vector<char> buf_;
+    size_t begin_, end_; // unread bytes are buf_[begin_, end_)
+    bool eof_;
+
+    static bool isBlank(char c) {
+        return c == ' ' || c == ',' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+    }
+
+    static void skipBlanks(const char*& s, const char* e) {
+        while (s < e && isBlank(*s)) s++;
+    }
+
+    template <typename T>
+    static bool parseNumber(const char*& s, const char* e, T& out) {
+        skipBlanks(s, e);
+        if (s < e && *s == '+') s++; // from_chars rejects a leading '+', streams do not
+        std::from_chars_result r = std::from_chars(s, e, out);
+        if (r.ec != std::errc()) return false;
+        s = r.ptr;
+        return true;
+    }
+
+    // Moves the unread tail to the front and appends one block. False at EOF
+    bool fill() {
+        if (eof_) return false;
+        if (begin_ > 0) {
+            memmove(buf_.data(), buf_.data() + begin_, end_ - begin_);
+            end_ -= begin_;
+            begin_ = 0;
+        }
+        if (buf_.size() - end_ < block_) buf_.resize(end_ + block_); // always room for a full block
+        ssize_t got;
+        do {
+            got = read(fd_, buf_.data() + end_, buf_.size() - end_);
+        } while (got < 0 && errno == EINTR);
+        if (got <= 0) {
+            eof_ = true;
+            return false;
+        }
+        end_ += got;
+        return true;
+    }
+
+    // Next line without its '\n'. Like getline, a final line without a
+    // newline still counts, an empty remainder at EOF does not
+    bool nextLine(const char*& line, const char*& stop) {
+        size_t scanned = begin_;
+        for (;;) {
+            const void* nl = memchr(buf_.data() + scanned, '\n', end_ - scanned);
+            if (nl) {
+                line = buf_.data() + begin_;
+                stop = static_cast<const char*>(nl);
+                begin_ = stop - buf_.data() + 1;
+                return true;
+            }
+            scanned = end_ - begin_;
+            if (!fill()) break;
+        }
+        if (begin_ == end_) return false;
+        line = buf_.data() + begin_;
+        stop = buf_.data() + end_;
+        begin_ = end_;
+        return true;
+    }
+};
+
+// Outcome of loading a whole point list. line is the 1-based point line of
+// an INVALID or EXTRA error
+struct PointLoad {
+    PointParser::Status status;
+    long line;
+};
+
+// Reads the count and that many points from fd
+template <typename P>
+PointLoad readPointStream(int fd, std::vector<P>& points) {
+    PointParser in(fd);
+    PointLoad load = { PointParser::OK, 0 };
+    int n;
+    if (!in.readCount(n) || n <= 0) {
+        load.status = PointParser::COUNT;
+        return load;
+    }
+    points.clear();
+    points.reserve(std::min(n, 1 << 20)); // the count is not trusted for huge sizes
+    for (int i = 0; i < n; ++i) {
+        P p;
+        load.status = in.readPoint(p);
+        if (load.status != PointParser::OK) {
+            load.line = i + 1;
+            return load;
+        }
+        points.push_back(p);
+    }
+    return load;
+}
+
+// Below this many bytes per thread a mapped file is parsed by one thread
+#define POINT_FILE_CHUNK (4 << 20)
+
+namespace parser_detail {
+
+// One thread's share of the file: whole lines [begin, end)
+struct Chunk {
+    const char* begin;
+    const char* end;
+    long lines;     // lines in the chunk
+    long first;     // index of its first line among all point lines
+    PointParser::Status status;
+    long bad;       // 1-based line of its first error
+};
+
+template <typename F>
+void runChunks(std::vector<Chunk>& chunks, F f) {
+    if (chunks.size() == 1) {
+        f(chunks[0]);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < chunks.size(); t++) workers.push_back(std::thread(f, std::ref(chunks[t])));
+    for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+}
+
+} // namespace parser_detail
+
+// Points of a binary point file (see PointFile.hpp), copied without parsing.
+// A truncated file is END, a bad header or a count of 0 is COUNT
+template <typename P>
+PointLoad loadPointFile(const char* data, size_t size, std::vector<P>& points) {
+    PointLoad load = { PointParser::COUNT, 0 };
+    PointFileHeader h;
+    if (!readPointFileHeader(data, size, h) || h.count == 0 || h.count > 0x7fffffff) return load;
+    uint64_t held = pointFileCapacity(h, size);
+    if (h.count > held) {
+        load.status = PointParser::END;
+        load.line = held + 1;
+        return load;
+    }
+    points.resize(h.count);
+    decodePointFile(data, h, points.data());
+    load.status = PointParser::OK;
+    return load;
+}
+
+// Maps the file at path and parses it in place on up to threads cores
+// (0 = all). The body is cut at line boundaries into one chunk per thread.
+// A first pass counts each chunk's lines, which gives every chunk its line
+// numbers and its slot range in the pre-sized points array. A second pass
+// parses the lines into those slots. The rules and errors are the same as
+// readPointStream's: the first bad line of the file is reported. Binary
+// point files are recognised by their magic and copied in directly.
+template <typename P>
+PointLoad mapPointFile(const char* path, std::vector<P>& points, unsigned threads = 0) {
+    using parser_detail::Chunk;
+    PointLoad load = { PointParser::OPEN, 0 };
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return load;
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return load;
+    }
+    size_t size = st.st_size;
+    void* map = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0) : nullptr;
+    close(fd);
+    if (map == MAP_FAILED) return load;
+    if (map) madvise(map, size, MADV_SEQUENTIAL);
+
+    const char* data = static_cast<const char*>(map);
+    if (isPointFile(data, size)) {
+        load = loadPointFile(data, size, points);
+        munmap(map, size);
+        return load;
+    }
+    const char* s = data;
+    const char* e = data + size;
+    int n;
+    load.status = PointParser::COUNT;
+    if (size == 0 || !PointParser::parseCount(s, e, n) || n <= 0) {
+        if (map) munmap(map, size);
+        return load;
+    }
+    if (s < e) s++; // the character after the count, as in readCount
+
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    threads = std::max<size_t>(1, std::min<size_t>(threads, (e - s) / POINT_FILE_CHUNK));
+
+    std::vector<Chunk> chunks(threads);
+    const char* at = s;
+    for (unsigned t = 0; t < threads; t++) {
+        const char* cut = t + 1 == threads ? e : s + (e - s) * (t + 1) / threads;
+        if (cut < at) cut = at;
+        const void* nl = cut < e ? memchr(cut, '\n', e - cut) : nullptr;
+        if (t + 1 < threads) cut = nl ? static_cast<const char*>(nl) + 1 : e;
+        Chunk c = { at, cut, 0, 0, PointParser::OK, 0 };
+        chunks[t] = c;
+        at = cut;
+    }
+
+    // Like getline, a final line without a newline counts
+    parser_detail::runChunks(chunks, [](Chunk& c) {
+        long lines = std::count(c.begin, c.end, '\n');
+        if (c.end > c.begin && c.end[-1] != '\n') lines++;
+        c.lines = lines;
+    });
+    long total = 0;
+    for (size_t t = 0; t < chunks.size(); t++) {
+        chunks[t].first = total;
+        total += chunks[t].lines;
+    }
+
+    long wanted = std::min<long>(n, total);
+    points.resize(wanted);
+    P* out = points.data();
+    parser_detail::runChunks(chunks, [out, wanted](Chunk& c) {
+        const char* line = c.begin;
+        for (long i = c.first; i < wanted && line < c.end; i++) {
+            const void* nl = memchr(line, '\n', c.end - line);
+            const char* stop = nl ? static_cast<const char*>(nl) : c.end;
+            c.status = PointParser::parseLine(line, stop, out[i]);
+            if (c.status != PointParser::OK) {
+                c.bad = i + 1;
+                return;
+            }
+            line = stop + 1;
+        }
+    });
+    munmap(map, size);
+
+    load.status = PointParser::OK;
+    for (size_t t = 0; t < chunks.size(); t++) {
+        if (chunks[t].status != PointParser::OK) {
+            load.status = chunks[t].status;
+            load.line = chunks[t].bad;
+            return load;
+        }
+    }
+    if (total < n) {
+        load.status = PointParser::END;
+        load.line = total + 1;
+    }
+    return load;
+}
+
+#endif // POINT_PARSER_HPP
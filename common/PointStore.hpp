@@ -0,0 +1,208 @@
+#ifndef POINT_STORE_HPP
+#define POINT_STORE_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+// Point container with O(1) insert, lookup and delete.
+//
+// Coordinates live in two dense arrays (x[] and y[]). An open-addressing
+// hash index (linear probing, backward-shift deletion) maps the quantized
+// coordinates to positions in those arrays. erase() swaps the last point into
+// the freed position, so the arrays never have holes.
+//
+// Two points match when |dx| < eps and |dy| < eps, the same rule as the
+// servers' Point::operator==. A matching point is always in one of the 3x3
+// neighbouring cells of size eps, so a lookup probes at most nine chains.
+// eps == 0 means exact comparison. Duplicates are allowed, and find() returns
+// any one of them. P is any point type with x and y members.
+template <typename P>
+class PointStore {
+public:
+    explicit PointStore(double eps) : eps_(eps), inv_(eps > 0 ? 1.0 / eps : 0.0), mask_(15), slots_(16, 0) {}
+
+    size_t size() const { return xs_.size(); }
+    bool empty() const { return xs_.empty(); }
+
+    // Point at position i (positions change on erase)
+    P operator[](size_t i) const {
+        P p;
+        p.x = xs_[i];
+        p.y = ys_[i];
+        return p;
+    }
+    P back() const { return (*this)[size() - 1]; }
+
+    // Bytes allocated for the points and their index
+    size_t memoryBytes() const {
+        return (xs_.capacity() + ys_.capacity()) * sizeof(double) + slots_.capacity() * sizeof(uint32_t);
+    }
+
+    const double* xs() const { return xs_.data(); }
+    const double* ys() const { return ys_.data(); }
+
+    // Copy of all points, in storage order
+    std::vector<P> toVector() const {
+        std::vector<P> out;
+        out.reserve(size());
+        for (size_t i = 0; i < size(); i++) out.push_back((*this)[i]);
+        return out;
+    }
+
+    double eps() const { return eps_; }
+
+    // Exchanges contents (and eps) with other in O(1)
+    void swap(PointStore& other) {
+        std::swap(eps_, other.eps_);
+        std::swap(inv_, other.inv_);
+        std::swap(mask_, other.mask_);
+        xs_.swap(other.xs_);
+        ys_.swap(other.ys_);
+        slots_.swap(other.slots_);
+    }
+
+    void reserve(size_t n) {
+        xs_.reserve(n);
+        ys_.reserve(n);
+        if (n * 2 > slots_.size()) rehash(n * 2);
+    }
+
+    void clear() {
+        xs_.clear();
+        ys_.clear();
+        std::fill(slots_.begin(), slots_.end(), 0);
+    }
+
+    void push_back(const P& p) {
+        if ((size() + 1) * 2 > slots_.size()) rehash(slots_.size() * 2);
+        xs_.push_back(p.x);
+        ys_.push_back(p.y);
+        link(size() - 1);
+    }
+
+    // Appends n points given as interleaved x, y pairs, growing the index once
+    void append(const double* xy, size_t n) {
+        if ((size() + n) * 2 > slots_.size()) rehash((size() + n) * 2);
+        for (size_t i = 0; i < n; i++) {
+            xs_.push_back(xy[2 * i]);
+            ys_.push_back(xy[2 * i + 1]);
+            link(size() - 1);
+        }
+    }
+
+    // Position of a point matching (x, y), or -1
+    long find(double x, double y) const {
+        if (eps_ <= 0) return probe(cellOf(x), cellOf(y), x, y);
+        int64_t cx = cellOf(x), cy = cellOf(y);
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                long i = probe(cx + dx, cy + dy, x, y);
+                if (i >= 0) return i;
+            }
+        }
+        return -1;
+    }
+
+    // Removes the point at position i; the last point takes its place
+    void erase(size_t i) {
+        unlink(slotOf(i));
+        size_t last = size() - 1;
+        if (i != last) {
+            slots_[slotOf(last)] = i + 1;
+            xs_[i] = xs_[last];
+            ys_[i] = ys_[last];
+        }
+        xs_.pop_back();
+        ys_.pop_back();
+    }
+
+    // Removes every point matching (x, y); returns how many were removed
+    size_t removeAll(double x, double y) {
+        size_t removed = 0;
+        long i;
+        while ((i = find(x, y)) >= 0) {
+            erase(i);
+            removed++;
+        }
+        return removed;
+    }
+
+private:
+    double eps_;
+    double inv_;
+    size_t mask_;
+    std::vector<double> xs_, ys_;
+    std::vector<uint32_t> slots_; // position + 1, 0 = empty
+
+    int64_t cellOf(double v) const {
+        if (eps_ <= 0) {
+            if (v == 0) v = 0; // -0.0 and 0.0 compare equal
+            int64_t bits;
+            std::memcpy(&bits, &v, sizeof(bits));
+            return bits;
+        }
+        double c = std::floor(v * inv_);
+        if (!(c > -9.0e18)) return INT64_MIN / 2; // also catches NaN
+        if (c > 9.0e18) return INT64_MAX / 2;
+        return (int64_t)c;
+    }
+
+    size_t home(int64_t cx, int64_t cy) const {
+        uint64_t h = (uint64_t)cx * 0x9E3779B97F4A7C15ULL ^ ((uint64_t)cy + 0x632BE59BD9B4E019ULL);
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ULL;
+        h ^= h >> 32;
+        return (size_t)h & mask_;
+    }
+
+    size_t homeOf(size_t i) const { return home(cellOf(xs_[i]), cellOf(ys_[i])); }
+
+    long probe(int64_t cx, int64_t cy, double x, double y) const {
+        for (size_t s = home(cx, cy); slots_[s] != 0; s = (s + 1) & mask_) {
+            size_t i = slots_[s] - 1;
+            bool match = eps_ <= 0 ? (xs_[i] == x && ys_[i] == y)
+                                   : (std::abs(xs_[i] - x) < eps_ && std::abs(ys_[i] - y) < eps_);
+            if (match) return (long)i;
+        }
+        return -1;
+    }
+
+    // Hash slot holding position i
+    size_t slotOf(size_t i) const {
+        size_t s = homeOf(i);
+        while (slots_[s] != i + 1) s = (s + 1) & mask_;
+        return s;
+    }
+
+    void link(size_t i) {
+        size_t s = homeOf(i);
+        while (slots_[s] != 0) s = (s + 1) & mask_;
+        slots_[s] = i + 1;
+    }
+
+    // Backward-shift deletion keeps every probe chain unbroken without tombstones
+    void unlink(size_t hole) {
+        for (size_t j = (hole + 1) & mask_; slots_[j] != 0; j = (j + 1) & mask_) {
+            size_t h = homeOf(slots_[j] - 1);
+            if (((j - h) & mask_) >= ((j - hole) & mask_)) {
+                slots_[hole] = slots_[j];
+                hole = j;
+            }
+        }
+        slots_[hole] = 0;
+    }
+
+    void rehash(size_t capacity) {
+        size_t cap = 16;
+        while (cap < capacity) cap *= 2;
+        slots_.assign(cap, 0);
+        mask_ = cap - 1;
+        for (size_t i = 0; i < size(); i++) link(i);
+    }
+};
+
+#endif // POINT_STORE_HPP
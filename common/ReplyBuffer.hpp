@@ -0,0 +1,26 @@
+#ifndef REPLY_BUFFER_HPP
+#define REPLY_BUFFER_HPP
+
+#include <string>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+// Replies to a batch of pipelined commands are appended to one string and
+// written with a single send() once the batch is done, instead of one send()
+// per command. Writes all of out to fd (retrying short writes) and empties
+// it. False if the peer is gone; MSG_NOSIGNAL keeps that from raising SIGPIPE
+inline bool flushReplies(int fd, std::string& out) {
+    size_t sent = 0;
+    while (sent < out.size()) {
+        ssize_t n = send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        sent += n;
+    }
+    bool ok = sent == out.size();
+    out.clear();
+    return ok;
+}
+
+#endif // REPLY_BUFFER_HPP
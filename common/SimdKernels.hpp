@@ -0,0 +1,238 @@
+#ifndef SIMD_KERNELS_HPP
+#define SIMD_KERNELS_HPP
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_KERNELS_X86 1
+#endif
+
+// Structure-of-Arrays point buffer and vectorized geometry kernels.
+//
+// Kernels are chosen at runtime: AVX-512, then AVX2, then scalar. All three
+// give bit-identical results. Every variant sums the shoelace terms into the
+// same 8 lanes (term i goes to lane i % 8), reduces the lanes in the same
+// order, and uses no fused multiply-add.
+
+namespace simd_detail {
+
+// When set, counts every AlignedAllocator allocation (the hull benchmark
+// points it at its own allocation counter)
+inline std::atomic<size_t>* aligned_allocations = nullptr;
+
+}
+
+// Allocator returning Align-byte aligned storage, so kernels can start on a
+// cache line
+template <typename T, size_t Align>
+struct AlignedAllocator {
+    typedef T value_type;
+    template <typename U> struct rebind { typedef AlignedAllocator<U, Align> other; };
+
+    AlignedAllocator() {}
+    template <typename U> AlignedAllocator(const AlignedAllocator<U, Align>&) {}
+
+    T* allocate(size_t n) {
+        void* p = nullptr;
+        if (posix_memalign(&p, Align, n * sizeof(T)) != 0) throw std::bad_alloc();
+        if (simd_detail::aligned_allocations) simd_detail::aligned_allocations->fetch_add(1, std::memory_order_relaxed);
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, size_t) { free(p); }
+
+    template <typename U> bool operator==(const AlignedAllocator<U, Align>&) const { return true; }
+    template <typename U> bool operator!=(const AlignedAllocator<U, Align>&) const { return false; }
+};
+
+typedef std::vector<double, AlignedAllocator<double, 64> > AlignedDoubles;
+
+// Points as separate, 64-byte aligned x[] and y[] arrays
+struct PointBuffer {
+    AlignedDoubles x, y;
+
+    size_t size() const { return x.size(); }
+    void clear() { x.clear(); y.clear(); }
+    void reserve(size_t n) { x.reserve(n); y.reserve(n); }
+    void push_back(double px, double py) { x.push_back(px); y.push_back(py); }
+
+    // Replace the contents with any container of points with x and y members
+    template <typename C>
+    void assign(const C& points) {
+        size_t n = points.size();
+        x.resize(n);
+        y.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            x[i] = points[i].x;
+            y[i] = points[i].y;
+        }
+    }
+};
+
+// g++ defaults to -ffp-contract=fast in C++ and would fuse the AVX-512 path
+// into FMAs, which round differently from the other variants
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+
+namespace simd_detail {
+
+// Lane reduction shared by every variant
+inline double reduceLanes(const double* l) {
+    return ((l[0] + l[1]) + (l[2] + l[3])) + ((l[4] + l[5]) + (l[6] + l[7]));
+}
+
+// One shoelace term, closing edge handled by the caller
+inline double term(const double* x, const double* y, size_t i, size_t j) {
+    double a = x[i] * y[j];
+    double b = x[j] * y[i];
+    return a - b;
+}
+
+inline double shoelaceScalar(const double* x, const double* y, size_t n) {
+    double lanes[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    for (size_t i = 0; i + 1 < n; i++) lanes[i & 7] += term(x, y, i, i + 1);
+    return reduceLanes(lanes) + term(x, y, n - 1, 0);
+}
+
+inline void orientScalar(const double* x, const double* y, size_t n,
+                         double ox, double oy, double ax, double ay, double* out) {
+    double dx = ax - ox, dy = ay - oy;
+    for (size_t i = 0; i < n; i++) {
+        double a = dx * (y[i] - oy);
+        double b = dy * (x[i] - ox);
+        out[i] = a - b;
+    }
+}
+
+#ifdef SIMD_KERNELS_X86
+__attribute__((target("avx2")))
+inline double shoelaceAvx2(const double* x, const double* y, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t m = n - 1, i = 0;
+    for (; i + 8 <= m; i += 8) {
+        __m256d t0 = _mm256_sub_pd(_mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i + 1)),
+                                   _mm256_mul_pd(_mm256_loadu_pd(x + i + 1), _mm256_loadu_pd(y + i)));
+        __m256d t1 = _mm256_sub_pd(_mm256_mul_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 5)),
+                                   _mm256_mul_pd(_mm256_loadu_pd(x + i + 5), _mm256_loadu_pd(y + i + 4)));
+        acc0 = _mm256_add_pd(acc0, t0);
+        acc1 = _mm256_add_pd(acc1, t1);
+    }
+    double lanes[8];
+    _mm256_storeu_pd(lanes, acc0);
+    _mm256_storeu_pd(lanes + 4, acc1);
+    for (; i < m; i++) lanes[i & 7] += term(x, y, i, i + 1);
+    return reduceLanes(lanes) + term(x, y, n - 1, 0);
+}
+
+__attribute__((target("avx2")))
+inline void orientAvx2(const double* x, const double* y, size_t n,
+                       double ox, double oy, double ax, double ay, double* out) {
+    __m256d vox = _mm256_set1_pd(ox), voy = _mm256_set1_pd(oy);
+    __m256d vdx = _mm256_set1_pd(ax - ox), vdy = _mm256_set1_pd(ay - oy);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d a = _mm256_mul_pd(vdx, _mm256_sub_pd(_mm256_loadu_pd(y + i), voy));
+        __m256d b = _mm256_mul_pd(vdy, _mm256_sub_pd(_mm256_loadu_pd(x + i), vox));
+        _mm256_storeu_pd(out + i, _mm256_sub_pd(a, b));
+    }
+    orientScalar(x + i, y + i, n - i, ox, oy, ax, ay, out + i);
+}
+
+__attribute__((target("avx512f")))
+inline double shoelaceAvx512(const double* x, const double* y, size_t n) {
+    __m512d acc = _mm512_setzero_pd();
+    size_t m = n - 1, i = 0;
+    for (; i + 8 <= m; i += 8) {
+        __m512d t = _mm512_sub_pd(_mm512_mul_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i + 1)),
+                                  _mm512_mul_pd(_mm512_loadu_pd(x + i + 1), _mm512_loadu_pd(y + i)));
+        acc = _mm512_add_pd(acc, t);
+    }
+    double lanes[8];
+    _mm512_storeu_pd(lanes, acc);
+    for (; i < m; i++) lanes[i & 7] += term(x, y, i, i + 1);
+    return reduceLanes(lanes) + term(x, y, n - 1, 0);
+}
+
+__attribute__((target("avx512f")))
+inline void orientAvx512(const double* x, const double* y, size_t n,
+                         double ox, double oy, double ax, double ay, double* out) {
+    __m512d vox = _mm512_set1_pd(ox), voy = _mm512_set1_pd(oy);
+    __m512d vdx = _mm512_set1_pd(ax - ox), vdy = _mm512_set1_pd(ay - oy);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d a = _mm512_mul_pd(vdx, _mm512_sub_pd(_mm512_loadu_pd(y + i), voy));
+        __m512d b = _mm512_mul_pd(vdy, _mm512_sub_pd(_mm512_loadu_pd(x + i), vox));
+        _mm512_storeu_pd(out + i, _mm512_sub_pd(a, b));
+    }
+    orientScalar(x + i, y + i, n - i, ox, oy, ax, ay, out + i);
+}
+#endif
+
+// Set SIMD_KERNELS=scalar|avx2|avx512 to force a variant (for benchmarking)
+inline int pickLevel() {
+    const char* force = getenv("SIMD_KERNELS");
+    int best = 0;
+#ifdef SIMD_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) best = 1;
+    if (__builtin_cpu_supports("avx512f")) best = 2;
+#endif
+    if (force) {
+        std::string f(force);
+        int want = f == "avx512" ? 2 : f == "avx2" ? 1 : 0;
+        if (want < best) best = want;
+    }
+    return best;
+}
+
+inline int level() {
+    static const int lvl = pickLevel();
+    return lvl;
+}
+
+} // namespace simd_detail
+
+#pragma GCC pop_options
+
+// Name of the kernel variant in use
+inline const char* simdKernelName() {
+    static const char* names[] = { "scalar", "avx2", "avx512" };
+    return names[simd_detail::level()];
+}
+
+// Twice the signed area of the polygon (x[i], y[i]), i = 0..n-1
+inline double shoelaceSum(const double* x, const double* y, size_t n) {
+    if (n < 3) return 0.0;
+#ifdef SIMD_KERNELS_X86
+    switch (simd_detail::level()) {
+    case 2: return simd_detail::shoelaceAvx512(x, y, n);
+    case 1: return simd_detail::shoelaceAvx2(x, y, n);
+    }
+#endif
+    return simd_detail::shoelaceScalar(x, y, n);
+}
+
+// Unsigned area of a polygon stored as SoA
+inline double polygonAreaSoA(const PointBuffer& poly) {
+    return std::abs(shoelaceSum(poly.x.data(), poly.y.data(), poly.size())) / 2.0;
+}
+
+// out[i] = cross(O, A, P_i) for every point P_i of the buffer
+inline void orientBatch(const double* x, const double* y, size_t n,
+                        double ox, double oy, double ax, double ay, double* out) {
+#ifdef SIMD_KERNELS_X86
+    switch (simd_detail::level()) {
+    case 2: simd_detail::orientAvx512(x, y, n, ox, oy, ax, ay, out); return;
+    case 1: simd_detail::orientAvx2(x, y, n, ox, oy, ax, ay, out); return;
+    }
+#endif
+    simd_detail::orientScalar(x, y, n, ox, oy, ax, ay, out);
+}
+
+#endif // SIMD_KERNELS_HPP
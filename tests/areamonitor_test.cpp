@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <vector>
+#include "../common/AreaMonitor.hpp"
+
+// AreaMonitor::judge across graph replacements: the stdout report starts
+// afresh after a reset, while Changed keeps comparing against the last area
+// subscribers were told, so dropping below a threshold is never missed.
+
+struct Event {
+    double a, b;
+    bool above;
+};
+static std::vector<Event> reports, changes;
+static int failures = 0;
+
+static void report(double level, bool above, double area) { reports.push_back(Event{ level, area, above }); }
+static void changed(double from, double to) { changes.push_back(Event{ from, to, to > from }); }
+
+// Whether a subscriber at level hears about the change, by Ex10's rule
+static bool crosses(const Event& e, double level) {
+    double lo = e.a < e.b ? e.a : e.b, hi = e.a < e.b ? e.b : e.a;
+    return lo < level && level <= hi;
+}
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                    \
+        }                                                                  \
+    } while (0)
+
+int main() {
+    AreaMonitor m;
+    m.addThreshold(100.0, 0.0);
+
+    // Subscriber at 100 is told "belongs" at 400
+    m.judge(400.0, false, report, changed);
+    CHECK(reports.size() == 1 && reports[0].above);
+    CHECK(changes.size() == 1 && crosses(changes[0], 100.0) && changes[0].above);
+
+    // Newgraph replaces the graph with one of area 25: no stdout report, but
+    // the subscriber hears "no longer belongs"
+    m.judge(25.0, true, report, changed);
+    CHECK(reports.size() == 1);
+    CHECK(changes.size() == 2 && changes[1].a == 400.0 && crosses(changes[1], 100.0) && !changes[1].above);
+
+    // Back to 400 with another Newgraph: both hear "belongs" once
+    m.judge(400.0, true, report, changed);
+    CHECK(reports.size() == 2 && reports[1].above);
+    CHECK(changes.size() == 3 && crosses(changes[2], 100.0) && changes[2].above);
+
+    // A replacement with the same area tells subscribers nothing, while the
+    // stdout report starts afresh
+    m.judge(400.0, true, report, changed);
+    CHECK(reports.size() == 3 && reports[2].above);
+    CHECK(changes.size() == 3);
+
+    if (failures) return 1;
+    printf("areamonitor_test: ok\n");
+    return 0;
+}
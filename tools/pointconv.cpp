@@ -0,0 +1,98 @@
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include "../common/PointFile.hpp"
+#include "../common/PointParser.hpp"
+
+using namespace std;
+
+// Converts between the text point format ("n" then "x,y" lines) and the
+// binary point file format. The direction follows the input: a binary file
+// becomes text, anything else is parsed as text and written as binary.
+//
+//   pointconv [-f32] <input> <output>
+//
+// -f32 stores single-precision coordinates (the default is float64).
+
+struct Point {
+    double x, y;
+};
+
+int main(int argc, char* argv[]) {
+    unsigned precision = 8;
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "-f32") == 0) {
+        precision = 4;
+        arg++;
+    }
+    if (argc - arg != 2) {
+        cerr << "Usage: " << argv[0] << " [-f32] <input> <output>" << endl;
+        return 1;
+    }
+    const char* input = argv[arg];
+    const char* output = argv[arg + 1];
+
+    // Peek at the header to learn the direction and the stored precision
+    char head[POINT_FILE_HEADER];
+    size_t got = 0;
+    FILE* in = fopen(input, "rb");
+    if (in) {
+        got = fread(head, 1, sizeof(head), in);
+        fclose(in);
+    }
+    PointFileHeader h = {};
+    bool binary = isPointFile(head, got);
+    if (binary && !readPointFileHeader(head, got, h)) {
+        cerr << "Error: Unsupported point file " << input << "." << endl;
+        return 1;
+    }
+
+    vector<Point> points;
+    PointLoad load = mapPointFile(input, points);
+    switch (load.status) {
+    case PointParser::OPEN:
+        cerr << "Error: Cannot read " << input << "." << endl;
+        return 1;
+    case PointParser::COUNT:
+        cerr << "Error: Invalid number of points." << endl;
+        return 1;
+    case PointParser::END:
+        cerr << "Error: Not enough input lines." << endl;
+        return 1;
+    case PointParser::INVALID:
+        cerr << "Error: Invalid point format at line " << load.line << "." << endl;
+        return 1;
+    case PointParser::EXTRA:
+        cerr << "Error: Extra data in line " << load.line << "." << endl;
+        return 1;
+    case PointParser::OK:
+        break;
+    }
+
+    FILE* out = fopen(output, binary ? "w" : "wb");
+    if (!out) {
+        cerr << "Error: Cannot write " << output << "." << endl;
+        return 1;
+    }
+    bool ok;
+    if (binary) {
+        // Enough digits for the stored values to read back exactly
+        const char* fmt = h.precision == 4 ? "%.9g,%.9g\n" : "%.17g,%.17g\n";
+        ok = fprintf(out, "%zu\n", points.size()) > 0;
+        for (size_t i = 0; ok && i < points.size(); i++) {
+            ok = fprintf(out, fmt, points[i].x, points[i].y) > 0;
+        }
+    } else {
+        ok = writePointFile(out, points, precision);
+    }
+    if (fclose(out) != 0) ok = false;
+    if (!ok) {
+        cerr << "Error: Cannot write " << output << "." << endl;
+        return 1;
+    }
+
+    cout << "Wrote " << points.size() << " points to " << output
+         << (binary ? " (text)" : precision == 4 ? " (binary, f32)" : " (binary, f64)") << "." << endl;
+    return 0;
+}